@@ -41,6 +41,39 @@ ArgumentParser::ArgumentParser(int argc, char** argv)
             case 'p':
                 arguments["path"] = optarg;
                 break;
+            case 'A':
+                arguments["all"] = "true";
+                break;
+            case 'a':
+                arguments["async"] = "true";
+                break;
+            case 'c':
+                arguments["coalesce"] = optarg;
+                break;
+            case 't':
+                arguments["pattern"] = optarg;
+                break;
+            case 's':
+                arguments["soft-blink"] = "true";
+                break;
+            case 'l':
+                arguments["lazy"] = "true";
+                break;
+            case 'n':
+                arguments["shared-name"] = "true";
+                break;
+            case 'N':
+                arguments["no-legacy-names"] = "true";
+                break;
+            case 'i':
+                arguments["idle-exit"] = optarg;
+                break;
+            case 'g':
+                arguments["phase-group"] = optarg;
+                break;
+            case 'j':
+                arguments["journal"] = "true";
+                break;
         }
     }
 }
@@ -66,6 +99,29 @@ void ArgumentParser::usage(char** argv)
     std::cerr << "    --help               Print this menu" << std::endl;
     std::cerr << "    --path=<path>        absolute path of LED in sysfs; like";
     std::cerr << " /sys/class/leds/<name>" << std::endl;
+    std::cerr << "    --all                serve every LED in /sys/class/leds";
+    std::cerr << " from this process" << std::endl;
+    std::cerr << "    --async              write sysfs from a worker thread";
+    std::cerr << " so D-Bus is never blocked" << std::endl;
+    std::cerr << "    --coalesce=<ms>      only write the last of the state";
+    std::cerr << " changes made within <ms>" << std::endl;
+    std::cerr << "    --pattern=<steps>    blink with the pattern trigger;";
+    std::cerr << " steps are \"<percent> <ms> ...\"" << std::endl;
+    std::cerr << "    --soft-blink         blink from this process even if";
+    std::cerr << " the timer trigger exists" << std::endl;
+    std::cerr << "    --lazy               read sysfs on first use or when";
+    std::cerr << " idle rather than at startup" << std::endl;
+    std::cerr << "    --shared-name        also serve all LEDs under";
+    std::cerr << " xyz.openbmc_project.LED.Controller" << std::endl;
+    std::cerr << "    --no-legacy-names    do not claim a bus name per LED";
+    std::cerr << ", requires --shared-name" << std::endl;
+    std::cerr << "    --idle-exit=<s>      save state and exit after <s>";
+    std::cerr << " seconds without requests, requires --no-legacy-names"
+              << std::endl;
+    std::cerr << "    --phase-group=<l,..> blink these LEDs, by D-Bus name,";
+    std::cerr << " in phase from this process" << std::endl;
+    std::cerr << "    --journal            record LED states under /run to";
+    std::cerr << " restart without probing sysfs" << std::endl;
 }
 } // namespace led
 } // namespace phosphor
@@ -44,12 +44,23 @@ class ArgumentParser
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
     static inline const option options[] = {
         {"path", required_argument, nullptr, 'p'},
+        {"all", no_argument, nullptr, 'A'},
+        {"async", no_argument, nullptr, 'a'},
+        {"coalesce", required_argument, nullptr, 'c'},
+        {"pattern", required_argument, nullptr, 't'},
+        {"soft-blink", no_argument, nullptr, 's'},
+        {"lazy", no_argument, nullptr, 'l'},
+        {"shared-name", no_argument, nullptr, 'n'},
+        {"no-legacy-names", no_argument, nullptr, 'N'},
+        {"idle-exit", required_argument, nullptr, 'i'},
+        {"phase-group", required_argument, nullptr, 'g'},
+        {"journal", no_argument, nullptr, 'j'},
         {"help", no_argument, nullptr, 'h'},
         {nullptr, 0, nullptr, 0},
     };
 
     /** @brief optstring as needed by getopt_long */
-    static inline const char* const optionstr = "p:?h";
+    static inline const char* const optionstr = "p:Aac:t:slnNi:g:j?h";
 };
 
 } // namespace led
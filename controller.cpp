@@ -15,13 +15,19 @@
  */
 
 #include "argument.hpp"
-#include "physical.hpp"
+#include "service.hpp"
 #include "sysfs.hpp"
 
-#include <boost/algorithm/string.hpp>
+#include <systemd/sd-daemon.h>
+
+#include <sdeventplus/event.hpp>
 
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
 static void exitWithError(const char* err, char** argv)
@@ -32,133 +38,140 @@ static void exitWithError(const char* err, char** argv)
     exit(-1);
 }
 
-struct LedDescr
-{
-    std::string devicename;
-    std::string color;
-    std::string function;
-};
-
-/** @brief parse LED name in sysfs
- *  Parse sysfs LED name in format "devicename:colour:function"
- *  or "devicename:colour" or "devicename" and sets corresponding
- *  fields in LedDescr struct.
- *
- *  @param[in] name      - LED name in sysfs
- *  @param[out] ledDescr - LED description
- */
-void getLedDescr(const std::string& name, LedDescr& ledDescr)
-{
-    std::vector<std::string> words;
-    boost::split(words, name, boost::is_any_of(":"));
-    try
-    {
-        ledDescr.devicename = words.at(0);
-        ledDescr.color = words.at(1);
-        ledDescr.function = words.at(2);
-    }
-    catch (const std::out_of_range&)
-    {
-        return;
-    }
-}
-
-/** @brief generates LED DBus name from LED description
- *
- *  @param[in] name      - LED description
- *  @return              - DBus LED name
- */
-std::string getDbusName(const LedDescr& ledDescr)
-{
-    std::vector<std::string> words;
-    words.emplace_back(ledDescr.devicename);
-    if (!ledDescr.function.empty())
-    {
-        words.emplace_back(ledDescr.function);
-    }
-    if (!ledDescr.color.empty())
-    {
-        words.emplace_back(ledDescr.color);
-    }
-    return boost::join(words, "_");
-}
-
 int main(int argc, char** argv)
 {
-    namespace fs = std::filesystem;
-    static constexpr auto busParent = "xyz.openbmc_project.LED.Controller";
-    static constexpr auto objParent = "/xyz/openbmc_project/led/physical";
     static constexpr auto devParent = "/sys/class/leds/";
 
     // Read arguments.
     auto options = phosphor::led::ArgumentParser(argc, argv);
+    auto all = options["all"] == "true";
 
     // FIXME: https://bugs.llvm.org/show_bug.cgi?id=41141
     // NOLINTBEGIN(clang-analyzer-cplusplus.NewDeleteLeaks)
 
     // Parse out Path argument.
-    if (options["path"].empty())
+    if (options["path"].empty() && !all)
     {
         exitWithError("Path not specified.", argv);
     }
+    if (!options["path"].empty() && all)
+    {
+        exitWithError("Path and all are mutually exclusive.", argv);
+    }
+    if (options["shared-name"] == "true" && !all)
+    {
+        exitWithError("Shared name requires all.", argv);
+    }
+    if (options["no-legacy-names"] == "true" &&
+        options["shared-name"] != "true")
+    {
+        exitWithError("No legacy names requires shared name.", argv);
+    }
+    if (!options["idle-exit"].empty() &&
+        options["no-legacy-names"] != "true")
+    {
+        // Only the shared name can be activated again, clients of a
+        // released legacy name would be left without a service
+        exitWithError("Idle exit requires no legacy names.", argv);
+    }
 
-    auto path = options["path"];
-
-    // If the LED has a hyphen in the name like: "one-two", then it gets passed
-    // as /one/two/ as opposed to /one-two to the service file. There is a
-    // change needed in systemd to solve this issue and hence putting in this
-    // work-around.
-
-    // Since this application always gets invoked as part of a udev rule,
-    // it is always guaranteed to get /sys/class/leds/one/two
-    // and we can go beyond leds/ to get the actual LED name.
-    // Refer: systemd/systemd#5072
-
-    // On an error, this throws an exception and terminates.
-    auto name = path.substr(strlen(devParent));
-
-    // LED names may have a hyphen and that would be an issue for
-    // dbus paths and hence need to convert them to underscores.
-    std::replace(name.begin(), name.end(), '/', '-');
-    path = devParent + name;
-
-    // Convert to lowercase just in case some are not and that
-    // we follow lowercase all over
-    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
-
-    // LED names may have a hyphen and that would be an issue for
-    // dbus paths and hence need to convert them to underscores.
-    std::replace(name.begin(), name.end(), '-', '_');
+    phosphor::led::Options settings;
+    settings.async = options["async"] == "true";
+    settings.softBlink = options["soft-blink"] == "true";
+    settings.lazy = options["lazy"] == "true";
+    settings.sharedName = options["shared-name"] == "true";
+    settings.legacyNames = options["no-legacy-names"] != "true";
+    settings.journal = options["journal"] == "true";
 
-    // Convert LED name in sysfs into DBus name
-    LedDescr ledDescr;
-    getLedDescr(name, ledDescr);
+    // Malformed values go through the usage path like any other error
+    std::string option;
+    try
+    {
+        if (!options["idle-exit"].empty())
+        {
+            option = "idle-exit";
+            settings.idleExit =
+                std::chrono::seconds(std::stoul(options["idle-exit"]));
+        }
+        if (!options["phase-group"].empty())
+        {
+            option = "phase-group";
+            settings.phaseGroup =
+                phosphor::led::parsePhaseGroup(options["phase-group"]);
+        }
+        if (!options["pattern"].empty())
+        {
+            option = "pattern";
+            settings.pattern = phosphor::led::parsePattern(options["pattern"]);
+        }
+        if (!options["coalesce"].empty())
+        {
+            option = "coalesce";
+            settings.coalesce =
+                std::chrono::milliseconds(std::stoul(options["coalesce"]));
+        }
+    }
+    catch (const std::logic_error& e)
+    {
+        auto err = "Invalid " + option + ": " + e.what();
+        exitWithError(err.c_str(), argv);
+    }
     // NOLINTEND(clang-analyzer-cplusplus.NewDeleteLeaks)
-    name = getDbusName(ledDescr);
-
-    // Unique bus name representing a single LED.
-    auto busName = std::string(busParent) + '.' + name;
-    auto objPath = std::string(objParent) + '/' + name;
 
-    // Get a handle to system dbus.
+    // Get a handle to system dbus and serve it from the event loop.
     auto bus = sdbusplus::bus::new_default();
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
 
-    sdbusplus::server::manager_t manager{bus, objPath.c_str()};
+    phosphor::led::Service service(bus, event, std::move(settings));
 
-    // Create the Physical LED objects for directing actions.
-    // Need to save this else sdbusplus destructor will wipe this off.
-    phosphor::led::SysfsLed sled{fs::path(path)};
-    phosphor::led::Physical led(bus, objPath, sled, ledDescr.color);
-
-    /** @brief Claim the bus */
-    bus.request_name(busName.c_str());
-
-    /** @brief Wait for client requests */
-    while (true)
+    if (all)
     {
-        // Handle dbus message / signals discarding unhandled
-        bus.process_discard();
-        bus.wait();
+        // One process for every LED, each under its usual bus name. LEDs
+        // coming and going later are followed from the kernel's uevents,
+        // watched first so that none falls between the two.
+        service.watchHotplug();
+        if (service.addAll() == 0)
+        {
+            std::cerr << "No LEDs found in " << devParent << std::endl;
+        }
     }
-    return 0;
+    else
+    {
+        auto path = options["path"];
+
+        // If the LED has a hyphen in the name like: "one-two", then it gets
+        // passed as /one/two/ as opposed to /one-two to the service file.
+        // There is a change needed in systemd to solve this issue and hence
+        // putting in this work-around.
+
+        // Since this application always gets invoked as part of a udev rule,
+        // it is always guaranteed to get /sys/class/leds/one/two
+        // and we can go beyond leds/ to get the actual LED name.
+        // Refer: systemd/systemd#5072
+
+        // On an error, this throws an exception and terminates.
+        auto name = path.substr(strlen(devParent));
+
+        // LED names may have a hyphen and that would be an issue for
+        // dbus paths and hence need to convert them to underscores.
+        std::replace(name.begin(), name.end(), '/', '-');
+
+        // Create the Physical LED object and claim its bus name. A LED that
+        // cannot be read is reported rather than aborting the process.
+        try
+        {
+            service.add(devParent + name);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to serve " << name << ": " << e.what()
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+        sd_notify(0, "READY=1");
+    }
+
+    /** @brief Wait for client requests and sysfs changes */
+    return event.loop();
 }
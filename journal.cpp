@@ -0,0 +1,156 @@
+#include "journal.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace phosphor
+{
+namespace led
+{
+/** @brief Layout of a journal file */
+struct Journal::Record
+{
+    uint32_t magic;
+    /** @brief Odd while written, zero when there is nothing recorded */
+    uint32_t sequence;
+    std::array<char, 40> boot;
+    uint64_t maxBrightness;
+    uint64_t brightness;
+    uint64_t delayOn;
+    uint64_t delayOff;
+    std::array<char, 32> trigger;
+};
+
+/** @brief Changes whenever Record does */
+static constexpr uint32_t recordMagic = 0x4c454431;
+
+/** @brief Copies a string into a fixed size field, nul terminated */
+template <size_t N>
+static void store(std::array<char, N>& field, const std::string& value)
+{
+    auto n = std::min(value.size(), N - 1);
+    std::memcpy(field.data(), value.data(), n);
+    field[n] = '\0';
+}
+
+template <size_t N>
+static std::string fetch(const std::array<char, N>& field)
+{
+    return {field.data(), strnlen(field.data(), N)};
+}
+
+Journal::Journal(const std::filesystem::path& file, const std::string& boot) :
+    boot(boot)
+{
+    std::filesystem::create_directories(file.parent_path());
+
+    int fd = open(file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                file.string());
+    }
+
+    // Leaves a record of the right size as it is, zeroes anything else
+    struct stat st = {};
+    if (fstat(fd, &st) < 0 ||
+        (st.st_size != sizeof(Record) &&
+         (ftruncate(fd, 0) < 0 || ftruncate(fd, sizeof(Record)) < 0)))
+    {
+        int err = errno;
+        close(fd);
+        throw std::system_error(err, std::generic_category(), file.string());
+    }
+
+    void* map = mmap(nullptr, sizeof(Record), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        throw std::system_error(err, std::generic_category(), file.string());
+    }
+    entry = static_cast<Record*>(map);
+}
+
+Journal::~Journal()
+{
+    munmap(entry, sizeof(Record));
+}
+
+void Journal::record(const Snapshot& snapshot)
+{
+    std::atomic_ref<uint32_t> sequence(entry->sequence);
+    auto n = sequence.load(std::memory_order_relaxed) | 1U;
+    if (n == UINT32_MAX)
+    {
+        n = 1;
+    }
+    sequence.store(n, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    entry->magic = recordMagic;
+    store(entry->boot, boot);
+    entry->maxBrightness = snapshot.maxBrightness;
+    entry->brightness = snapshot.brightness;
+    entry->delayOn = snapshot.delayOn;
+    entry->delayOff = snapshot.delayOff;
+    store(entry->trigger, snapshot.trigger);
+
+    sequence.store(n + 1, std::memory_order_release);
+}
+
+void Journal::invalidate()
+{
+    std::atomic_ref<uint32_t>(entry->sequence)
+        .store(0, std::memory_order_release);
+}
+
+std::optional<Snapshot> Journal::load() const
+{
+    std::atomic_ref<uint32_t> sequence(entry->sequence);
+    auto n = sequence.load(std::memory_order_acquire);
+    if (n == 0 || (n & 1U) != 0 || entry->magic != recordMagic ||
+        fetch(entry->boot) != boot)
+    {
+        return std::nullopt;
+    }
+
+    Snapshot snapshot;
+    snapshot.maxBrightness = entry->maxBrightness;
+    snapshot.trigger = fetch(entry->trigger);
+    snapshot.brightness = entry->brightness;
+    snapshot.delayOn = entry->delayOn;
+    snapshot.delayOff = entry->delayOff;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence.load(std::memory_order_relaxed) != n)
+    {
+        return std::nullopt;
+    }
+    return snapshot;
+}
+
+const std::string& Journal::bootId()
+{
+    static const std::string id = [] {
+        std::string value;
+        std::ifstream in("/proc/sys/kernel/random/boot_id");
+        std::getline(in, value);
+        return value;
+    }();
+    return id;
+}
+} // namespace led
+} // namespace phosphor
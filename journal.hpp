@@ -0,0 +1,65 @@
+#pragma once
+
+#include "physical.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace phosphor
+{
+namespace led
+{
+/** @class Journal
+ *  @brief Keeps what sysfs holds for one LED in a small memory-mapped file,
+ *         so that an instance started again after a crash or restart can
+ *         take it instead of probing the LED.
+ *
+ *  Recording is a few stores into the mapping, with no system call. A
+ *  sequence number is odd while a record is being written, which tells a
+ *  record torn by a crash, and the boot id tells one left from a previous
+ *  boot.
+ */
+class Journal
+{
+  public:
+    Journal() = delete;
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+    Journal(Journal&&) = delete;
+    Journal& operator=(Journal&&) = delete;
+
+    /** @brief Maps the journal file of a LED, creating it if needed
+     *
+     *  @param[in] file - journal file, its directory is created if needed
+     *  @param[in] boot - id of the current boot
+     */
+    explicit Journal(const std::filesystem::path& file,
+                     const std::string& boot = bootId());
+
+    ~Journal();
+
+    /** @brief Records the settings sysfs now holds */
+    void record(const Snapshot& snapshot);
+
+    /** @brief Drops the record, for settings that cannot be restored */
+    void invalidate();
+
+    /** @brief Reads the record left by this or an earlier instance
+     *
+     *  @return The settings, or nothing if there is no complete record
+     *          from the current boot
+     */
+    std::optional<Snapshot> load() const;
+
+    /** @brief Id of the current boot, read once */
+    static const std::string& bootId();
+
+  private:
+    struct Record;
+
+    Record* entry = nullptr;
+    std::string boot;
+};
+} // namespace led
+} // namespace phosphor
@@ -0,0 +1,59 @@
+#include "monitor.hpp"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <array>
+#include <exception>
+#include <iostream>
+
+namespace phosphor
+{
+namespace led
+{
+Monitor::Monitor(const sdeventplus::Event& event,
+                 const std::filesystem::path& root, Callback&& callback) :
+    callback(std::move(callback))
+{
+    for (const auto* name : notifiable)
+    {
+        auto watch = std::make_unique<Watch>(name);
+        int fd = watch->file.get(root);
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        // A notification is only reported once the attribute has been
+        // read through the descriptor, so consume the current value first.
+        std::array<char, 64> buf{};
+        (void)pread(fd, buf.data(), buf.size(), 0);
+
+        // Sysfs always reports readable, only EPOLLPRI signals a change
+        watch->source.emplace(
+            event, fd, EPOLLPRI,
+            [this, w = watch.get()](sdeventplus::source::IO&, int fd,
+                                    uint32_t) { changed(*w, fd); });
+        watches.emplace_back(std::move(watch));
+    }
+}
+
+void Monitor::changed(const Watch& watch, int fd)
+{
+    // Rearm the notification. brightness_hw_changed fails with ENODATA
+    // until the hardware first changes it, which does not matter here.
+    std::array<char, 64> buf{};
+    (void)pread(fd, buf.data(), buf.size(), 0);
+
+    try
+    {
+        callback();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Failed to handle change of " << watch.file.name << ": "
+                  << e.what() << std::endl;
+    }
+}
+} // namespace led
+} // namespace phosphor
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "sysfs.hpp"
+
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/io.hpp>
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace phosphor
+{
+namespace led
+{
+/** @class Monitor
+ *  @brief Watches the attributes of a LED that the kernel flags through
+ *         sysfs_notify(), so changes made by the hardware are noticed
+ *         without polling.
+ *
+ *  The LED core only notifies brightness_hw_changed, which LEDs with
+ *  LED_BRIGHT_HW_CHANGED provide. Writes to brightness or trigger by other
+ *  tools, and brightness set by a trigger, are not notified and so are not
+ *  seen.
+ */
+class Monitor
+{
+  public:
+    using Callback = std::function<void()>;
+
+    Monitor() = delete;
+    ~Monitor() = default;
+    Monitor(const Monitor&) = delete;
+    Monitor& operator=(const Monitor&) = delete;
+    Monitor(Monitor&&) = delete;
+    Monitor& operator=(Monitor&&) = delete;
+
+    /** @brief Starts watching the LED
+     *
+     *  @param[in] event    - event loop to watch from
+     *  @param[in] root     - sysfs directory of the LED
+     *  @param[in] callback - invoked from the event loop on every change
+     */
+    Monitor(const sdeventplus::Event& event,
+            const std::filesystem::path& root, Callback&& callback);
+
+    /** @brief Number of attributes actually being watched */
+    size_t watched() const
+    {
+        return watches.size();
+    }
+
+  private:
+    /** @brief Attributes which may be notified. Those the LED does not
+     *         provide are skipped; the others cost nothing until notified.
+     */
+    static constexpr auto notifiable = {"brightness_hw_changed"};
+
+    struct Watch
+    {
+        explicit Watch(const char* name) : file(name)
+        {}
+
+        SysfsAttr file;
+        std::optional<sdeventplus::source::IO> source;
+    };
+
+    /** @brief Handles a notification on one of the attributes
+     *
+     *  @param[in] watch - the notified attribute
+     *  @param[in] fd    - its descriptor
+     */
+    void changed(const Watch& watch, int fd);
+
+    Callback callback;
+    std::vector<std::unique_ptr<Watch>> watches;
+};
+} // namespace led
+} // namespace phosphor
@@ -16,33 +16,115 @@
 
 #include "physical.hpp"
 
+#include "journal.hpp"
+
+#include <xyz/openbmc_project/Common/error.hpp>
+
 #include <cassert>
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <system_error>
+#include <tuple>
+#include <utility>
 namespace phosphor
 {
 namespace led
 {
 
+Physical::~Physical()
+{
+    // Queued jobs refer to this object and its LED
+    if (worker != nullptr)
+    {
+        worker->flush();
+    }
+    if (softBlink != nullptr)
+    {
+        softBlink->stop(led.path());
+    }
+}
+
+auto Physical::probe(SysfsLed& led) -> Snapshot
+{
+    Snapshot snapshot;
+    snapshot.maxBrightness = led.getMaxBrightness();
+    snapshot.trigger = led.getTrigger();
+    if (snapshot.trigger == "timer")
+    {
+        snapshot.delayOn = led.getDelayOn();
+        snapshot.delayOff = led.getDelayOff();
+    }
+    else
+    {
+        snapshot.brightness = led.getBrightness();
+    }
+    if (snapshot.trigger == "pattern")
+    {
+        snapshot.pattern = led.getPattern();
+    }
+    return snapshot;
+}
+
+/** @brief Tells what drives a LED from the name of its trigger */
+static Trigger triggerOf(const std::string& name)
+{
+    if (name == "none")
+    {
+        return Trigger::None;
+    }
+    if (name == "timer")
+    {
+        return Trigger::Timer;
+    }
+    if (name == "pattern")
+    {
+        return Trigger::Pattern;
+    }
+    return Trigger::Other;
+}
+
 /** @brief Populates key parameters */
 void Physical::setInitialState()
 {
-    assert = led.getMaxBrightness();
-    auto trigger = led.getTrigger();
-    if (trigger == "timer")
+    apply(probe(led));
+}
+
+void Physical::apply(const Snapshot& snapshot)
+{
+    bool engine = softBlink != nullptr && written.action == Action::Blink &&
+                  snapshot.trigger == "none";
+
+    assert = snapshot.maxBrightness;
+    if (snapshot.trigger == "timer")
     {
         // LED is blinking. Get the on and off delays and derive percent duty
-        auto delayOn = led.getDelayOn();
-        uint16_t periodMs = delayOn + led.getDelayOff();
-        auto percentScale = periodMs / 100;
-        this->dutyOn(delayOn / percentScale);
-        this->period(periodMs);
+        auto [duty, periodMs] = toTiming(snapshot.delayOn, snapshot.delayOff);
+
+        // What sysfs already has must not be written back to it
+        sdbusplus::xyz::openbmc_project::Led::server::Physical::dutyOn(
+            duty, false);
+        sdbusplus::xyz::openbmc_project::Led::server::Physical::period(
+            periodMs, false);
+        sdbusplus::xyz::openbmc_project::Led::server::Physical::state(
+            Action::Blink);
+    }
+    else if (snapshot.trigger == "pattern")
+    {
+        // Still playing the sequence set up before a restart
+        sdbusplus::xyz::openbmc_project::Led::server::Physical::state(
+            Action::Blink);
+    }
+    else if (engine)
+    {
+        // Still blinking from the software engine, brightness is in flux
     }
     else
     {
         // Cache current LED state
-        auto brightness = led.getBrightness();
+        auto brightness = snapshot.brightness;
         if (brightness != 0U && assert != 0U)
         {
             sdbusplus::xyz::openbmc_project::Led::server::Physical::state(
@@ -54,73 +136,640 @@ void Physical::setInitialState()
                 Action::Off);
         }
     }
+
+    // What sysfs holds is what the next change starts from
+    written = target(state());
+    if (!engine)
+    {
+        written.trigger = triggerOf(snapshot.trigger);
+        if (written.trigger != Trigger::None)
+        {
+            written.level = Brightness::Unknown;
+        }
+        else
+        {
+            written.level = (snapshot.brightness != 0U) ? Brightness::Lit
+                                                        : Brightness::Zero;
+        }
+    }
+    if (snapshot.trigger == "pattern")
+    {
+        foundPattern = snapshot.pattern;
+    }
+    else
+    {
+        foundPattern.reset();
+    }
+    matchPattern();
+    record(written);
+}
+
+void Physical::matchPattern()
+{
+    if (!foundPattern)
+    {
+        return;
+    }
+    written.trigger = (*foundPattern == scaledPattern(assert))
+                          ? Trigger::Pattern
+                          : Trigger::Other;
+}
+
+void Physical::ensureProbed()
+{
+    if (probed)
+    {
+        return;
+    }
+
+    // Reading sysfs calls back into the getters
+    probed = true;
+    try
+    {
+        setInitialState();
+    }
+    catch (const std::system_error& e)
+    {
+        probed = false;
+        std::cerr << "Failed to read LED: " << e.what() << std::endl;
+        throw sdbusplus::xyz::openbmc_project::Common::Error::
+            InternalFailure();
+    }
+
+    emit_object_added();
+    if (onProbed)
+    {
+        std::exchange(onProbed, nullptr)();
+    }
+}
+
+void Physical::refresh()
+{
+    if (!probed)
+    {
+        ensureProbed();
+        return;
+    }
+
+    if (worker == nullptr)
+    {
+        led.invalidate();
+        setInitialState();
+        return;
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    auto queued = submit(
+        [this, snapshot]() {
+            led.invalidate();
+            *snapshot = probe(led);
+        },
+        [this, snapshot]() { apply(*snapshot); });
+    if (!queued)
+    {
+        std::cerr << "Dropping LED refresh, writer queue is full"
+                  << std::endl;
+    }
+}
+
+void Physical::setWorker(Worker& worker)
+{
+    this->worker = &worker;
+}
+
+bool Physical::submit(Worker::Job&& job, std::function<void()>&& then)
+{
+    std::weak_ptr<bool> token = alive;
+    return worker->submit(
+        std::move(job),
+        [this, token, then = std::move(then)](std::exception_ptr error) {
+            if (token.expired())
+            {
+                return;
+            }
+            if (error)
+            {
+                try
+                {
+                    std::rethrow_exception(error);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Failed to drive LED: " << e.what()
+                              << std::endl;
+                }
+                // Report what the LED actually does rather than what was
+                // asked for. A failing probe ends here without looping.
+                refreshAfterError();
+                return;
+            }
+            then();
+        });
+}
+
+void Physical::refreshAfterError()
+{
+    auto snapshot = std::make_shared<Snapshot>();
+    std::weak_ptr<bool> token = alive;
+    worker->submit(
+        [this, snapshot]() {
+            led.invalidate();
+            *snapshot = probe(led);
+        },
+        [this, token, snapshot](std::exception_ptr error) {
+            if (!token.expired() && !error)
+            {
+                apply(*snapshot);
+            }
+        });
 }
 
 auto Physical::state() const -> Action
 {
+    // Properties are read from sysfs on first use, D-Bus only reads them
+    // through these getters
+    const_cast<Physical*>(this)->ensureProbed();
     return sdbusplus::xyz::openbmc_project::Led::server::Physical::state();
 }
 
+uint8_t Physical::dutyOn() const
+{
+    const_cast<Physical*>(this)->ensureProbed();
+    return sdbusplus::xyz::openbmc_project::Led::server::Physical::dutyOn();
+}
+
+uint8_t Physical::dutyOn(uint8_t value, bool skipSignal)
+{
+    ensureProbed();
+
+    auto request = target(Action::Blink);
+    request.dutyOn = value;
+    retime(request);
+
+    return sdbusplus::xyz::openbmc_project::Led::server::Physical::dutyOn(
+        value, skipSignal);
+}
+
+uint16_t Physical::period() const
+{
+    const_cast<Physical*>(this)->ensureProbed();
+    return sdbusplus::xyz::openbmc_project::Led::server::Physical::period();
+}
+
+uint16_t Physical::period(uint16_t value, bool skipSignal)
+{
+    ensureProbed();
+
+    auto request = target(Action::Blink);
+    request.period = value;
+    retime(request);
+
+    return sdbusplus::xyz::openbmc_project::Led::server::Physical::period(
+        value, skipSignal);
+}
+
 auto Physical::state(Action value) -> Action
 {
-    auto current =
-        sdbusplus::xyz::openbmc_project::Led::server::Physical::state();
+    return changeState(value, false);
+}
+
+std::vector<std::string> Physical::update(Action action, uint8_t dutyOn,
+                                          uint16_t period)
+{
+    using Base = sdbusplus::xyz::openbmc_project::Led::server::Physical;
 
-    auto requested =
-        sdbusplus::xyz::openbmc_project::Led::server::Physical::state(value);
+    ensureProbed();
 
-    driveLED(current, requested);
+    auto oldState = Base::state();
+    auto oldDutyOn = Base::dutyOn();
+    auto oldPeriod = Base::period();
+
+    // The blink parameters are taken from the properties
+    Base::dutyOn(dutyOn, true);
+    Base::period(period, true);
+    try
+    {
+        changeState(action, true);
+    }
+    catch (...)
+    {
+        Base::dutyOn(oldDutyOn, true);
+        Base::period(oldPeriod, true);
+        throw;
+    }
+
+    std::vector<std::string> changed;
+    if (action != oldState)
+    {
+        changed.emplace_back("State");
+    }
+    if (dutyOn != oldDutyOn)
+    {
+        changed.emplace_back("DutyOn");
+    }
+    if (period != oldPeriod)
+    {
+        changed.emplace_back("Period");
+    }
+    return changed;
+}
+
+auto Physical::changeState(Action value, bool skipSignal) -> Action
+{
+    ensureProbed();
+
+    if (coalesceTimer)
+    {
+        // Only the last state within the window gets to sysfs
+        ++pending;
+        if (!coalesceTimer->isEnabled())
+        {
+            coalesceTimer->restartOnce(coalesceWindow);
+        }
+    }
+    else
+    {
+        commit(target(value));
+    }
+
+    sdbusplus::xyz::openbmc_project::Led::server::Physical::state(value,
+                                                                  skipSignal);
 
     return value;
 }
 
-void Physical::driveLED(Action current, Action request)
+void Physical::retime(const Target& request)
 {
-    if (current == request)
+    // A state change still in the window picks the new timing up
+    if (state() != Action::Blink || pending != 0)
     {
         return;
     }
+    commit(request);
+}
 
-    if (request == Action::On || request == Action::Off)
+void Physical::commit(const Target& request)
+{
+    if (worker != nullptr)
     {
-        return stableStateOperation(request);
+        // Acknowledge right away and leave sysfs to the worker
+        if (!program(request))
+        {
+            throw sdbusplus::xyz::openbmc_project::Common::Error::
+                Unavailable();
+        }
+        return;
     }
 
-    assert(request == Action::Blink);
-    blinkOperation();
+    try
+    {
+        program(request);
+    }
+    catch (const std::system_error& e)
+    {
+        std::cerr << "Failed to drive LED: " << e.what() << std::endl;
+        throw sdbusplus::xyz::openbmc_project::Common::Error::
+            InternalFailure();
+    }
 }
 
-void Physical::stableStateOperation(Action action)
+void Physical::setJournal(Journal& journal)
 {
-    auto value = (action == Action::On) ? assert : deasserted;
+    this->journal = &journal;
+    record(written);
+}
+
+void Physical::record(const Target& state)
+{
+    if (journal == nullptr)
+    {
+        return;
+    }
+
+    Snapshot snapshot;
+    snapshot.maxBrightness = assert;
+    if (state.action != Action::Blink && state.trigger == Trigger::None)
+    {
+        snapshot.trigger = "none";
+        snapshot.brightness =
+            (state.action == Action::On) ? state.brightness : deasserted;
+    }
+    else if (state.action == Action::Blink && state.trigger == Trigger::Timer)
+    {
+        snapshot.trigger = "timer";
+        std::tie(snapshot.delayOn, snapshot.delayOff) = blinkDelays(state);
+    }
+    else if (state.action == Action::Blink &&
+             state.trigger == Trigger::Pattern)
+    {
+        snapshot.trigger = "pattern";
+    }
+    else
+    {
+        // The software engine stops with the process, and other triggers
+        // cannot be told apart
+        journal->invalidate();
+        return;
+    }
+    journal->record(snapshot);
+}
 
-    led.setTrigger("none");
-    led.setBrightness(value);
+void Physical::setCoalesceWindow(const sdeventplus::Event& event,
+                                 std::chrono::milliseconds window)
+{
+    coalesceWindow = window;
+    coalesceTimer.emplace(event, [this](Timer&) { flush(); });
 }
 
-void Physical::blinkOperation()
+void Physical::setSoftBlink(SoftBlink& engine, bool force)
 {
-    /*
-      The configuration of the trigger type must precede the configuration of
-      the trigger type properties. From the kernel documentation:
-      "You can change triggers in a similar manner to the way an IO scheduler
-      is chosen (via /sys/class/leds/<device>/trigger). Trigger specific
-      parameters can appear in /sys/class/leds/<device> once a given trigger is
-      selected."
-      Refer:
-      https://git.kernel.org/pub/scm/linux/kernel/git/torvalds/linux.git/tree/Documentation/leds/leds-class.txt?h=v5.2#n26
-    */
-    auto d = static_cast<unsigned long>(dutyOn());
-    if (d > 100)
+    if (!force && led.hasTrigger("timer"))
     {
-        d = 100;
+        return;
     }
+    softBlink = &engine;
 
-    auto p = static_cast<unsigned long>(period());
+    // A blink left running on the kernel timer is taken over right away
+    if (!probed || written.action != Action::Blink ||
+        written.trigger != Trigger::Timer)
+    {
+        return;
+    }
+    try
+    {
+        if (!program(target(Action::Blink)))
+        {
+            std::cerr << "Failed to take over blinking: worker busy"
+                      << std::endl;
+        }
+    }
+    catch (const std::system_error& e)
+    {
+        std::cerr << "Failed to take over blinking: " << e.what()
+                  << std::endl;
+        refresh();
+    }
+}
 
-    led.setTrigger("timer");
-    led.setDelayOn(p * d / 100UL);
-    led.setDelayOff(p * (100UL - d) / 100UL);
+void Physical::setBlinkPattern(Pattern&& pattern)
+{
+    for (const auto& step : pattern)
+    {
+        if (step.brightness > 100)
+        {
+            throw std::invalid_argument("Pattern brightness above 100%");
+        }
+    }
+
+    if (!pattern.empty() && !led.hasTrigger("pattern"))
+    {
+        std::cerr << "Pattern trigger unavailable, blinking with the timer"
+                  << std::endl;
+        return;
+    }
+
+    blinkPattern = std::move(pattern);
+    matchPattern();
+}
+
+void Physical::flush()
+{
+    if (pending == 0)
+    {
+        return;
+    }
+
+    // Every change but the last was replaced by a later one
+    auto request = target(state());
+    collapsed += pending - 1;
+    pending = 0;
+
+    try
+    {
+        if (!program(request))
+        {
+            // Try again once the worker caught up
+            pending = 1;
+            coalesceTimer->restartOnce(coalesceWindow);
+        }
+    }
+    catch (const std::system_error& e)
+    {
+        std::cerr << "Failed to drive LED: " << e.what() << std::endl;
+        refresh();
+    }
+}
+
+bool Physical::program(const Target& request)
+{
+    auto current = written;
+    foundPattern.reset();
+    bool soft = softBlink != nullptr && blinkPattern.empty();
+
+    // The engine has to let go before anything else gets written
+    if (soft && current.action == Action::Blink &&
+        request.action != Action::Blink)
+    {
+        softBlink->stop(led.path());
+    }
+
+    if (worker == nullptr)
+    {
+        driveLED(current, request);
+        record(request);
+    }
+    else if (needsWrites(current, request))
+    {
+        // The engine only starts once the worker dropped the trigger, and
+        // not at all if a later change superseded this one meanwhile
+        auto queued = submit(
+            [this, current, request]() { driveLED(current, request); },
+            [this, soft, request]() {
+                record(request);
+                if (soft && request.action == Action::Blink &&
+                    written.action == Action::Blink &&
+                    !retimed(written, request))
+                {
+                    startSoftBlink(request);
+                }
+            });
+        if (!queued)
+        {
+            return false;
+        }
+        written = request;
+        return true;
+    }
+
+    written = request;
+
+    if (soft && request.action == Action::Blink && worker == nullptr)
+    {
+        startSoftBlink(request);
+    }
+    return true;
+}
+
+void Physical::startSoftBlink(const Target& request)
+{
+    auto [on, off] = blinkDelays(request);
+    softBlink->start(led.path(), request.brightness, on, off);
+}
+
+auto Physical::target(Action action) const -> Target
+{
+    Target request{action, assert, dutyOn(), period(), Trigger::None,
+                   Brightness::Zero};
+    if (action == Action::On)
+    {
+        request.level = Brightness::Lit;
+    }
+    else if (action == Action::Blink)
+    {
+        if (!blinkPattern.empty())
+        {
+            request.trigger = Trigger::Pattern;
+        }
+        else if (softBlink == nullptr)
+        {
+            request.trigger = Trigger::Timer;
+        }
+        request.level = Brightness::Unknown;
+    }
+    return request;
+}
+
+bool Physical::retimed(const Target& current, const Target& request)
+{
+    return current.action == Action::Blink &&
+           request.action == Action::Blink &&
+           (current.dutyOn != request.dutyOn ||
+            current.period != request.period);
+}
+
+Goal Physical::goal(const Target& request)
+{
+    switch (request.action)
+    {
+        case Action::On:
+            return Goal::On;
+        case Action::Blink:
+            if (request.trigger == Trigger::Timer)
+            {
+                return Goal::Timer;
+            }
+            if (request.trigger == Trigger::Pattern)
+            {
+                return Goal::Pattern;
+            }
+            return Goal::Soft;
+        default:
+            return Goal::Off;
+    }
+}
+
+bool Physical::unchanged(Write write, const Target& current,
+                         const Target& request)
+{
+    // The timer already runs with these delays
+    return write == Write::Delays && current.action == Action::Blink &&
+           !retimed(current, request);
+}
+
+bool Physical::needsWrites(const Target& current, const Target& request)
+{
+    for (auto write : plan(current.trigger, current.level, goal(request)))
+    {
+        if (!unchanged(write, current, request))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Physical::driveLED(const Target& current, const Target& request)
+{
+    // Decided from the trigger in place rather than the action, as the
+    // engine taking over a kernel blink still has to drop the trigger
+    if (!needsWrites(current, request))
+    {
+        return;
+    }
+
+    // Software blinking wrote brightness behind SysfsLed's back
+    if (softBlink != nullptr && current.action == Action::Blink &&
+        request.action != Action::Blink)
+    {
+        led.invalidate();
+    }
+
+    for (auto write : plan(current.trigger, current.level, goal(request)))
+    {
+        if (!unchanged(write, current, request))
+        {
+            perform(write, request);
+        }
+    }
+}
+
+void Physical::perform(Write write, const Target& request)
+{
+    switch (write)
+    {
+        case Write::TriggerNone:
+            led.setTrigger("none");
+            break;
+        case Write::Brightness:
+            led.setBrightness(request.action == Action::On ? request.brightness
+                                                           : deasserted);
+            break;
+        case Write::Blink:
+        {
+            /*
+              The configuration of the trigger type must precede the
+              configuration of the trigger type properties, which setBlink
+              takes care of. From the kernel documentation:
+              "You can change triggers in a similar manner to the way an IO
+              scheduler is chosen (via /sys/class/leds/<device>/trigger).
+              Trigger specific parameters can appear in
+              /sys/class/leds/<device> once a given trigger is selected."
+              Refer:
+              https://git.kernel.org/pub/scm/linux/kernel/git/torvalds/linux.git/tree/Documentation/leds/leds-class.txt?h=v5.2#n26
+            */
+            auto [on, off] = blinkDelays(request);
+            led.setBlink(on, off);
+            break;
+        }
+        case Write::Delays:
+        {
+            // SysfsLed skips a delay that stays the same
+            auto [on, off] = blinkDelays(request);
+            led.setDelayOn(on);
+            led.setDelayOff(off);
+            break;
+        }
+        case Write::Pattern:
+            led.setPattern(scaledPattern(request.brightness));
+            break;
+    }
+}
+
+auto Physical::blinkDelays(const Target& request)
+    -> std::pair<unsigned long, unsigned long>
+{
+    return toDelays(request.dutyOn, request.period);
+}
+
+Pattern Physical::scaledPattern(unsigned long brightness) const
+{
+    Pattern scaled;
+    scaled.reserve(blinkPattern.size());
+    for (const auto& step : blinkPattern)
+    {
+        scaled.push_back({step.brightness * brightness / 100, step.duration});
+    }
+    return scaled;
 }
 
 /** @brief set led color property in DBus*/
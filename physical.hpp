@@ -1,24 +1,62 @@
 #pragma once
 
+#include "softblink.hpp"
 #include "sysfs.hpp"
+#include "timing.hpp"
+#include "transition.hpp"
+#include "worker.hpp"
 
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server/object.hpp>
+#include <sdeventplus/clock.hpp>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/utility/timer.hpp>
 #include <xyz/openbmc_project/Led/Physical/server.hpp>
 
+#include <chrono>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace phosphor
 {
 namespace led
 {
+class Journal;
+
 /** @brief De-assert value */
 constexpr unsigned long deasserted = 0;
 
 using PhysicalIfaces = sdbusplus::server::object_t<
     sdbusplus::xyz::openbmc_project::Led::server::Physical>;
 
+/** @brief LED settings as read back from sysfs */
+struct Snapshot
+{
+    unsigned long maxBrightness = 0;
+    std::string trigger;
+    /** @brief Only read when no blink trigger is active */
+    unsigned long brightness = 0;
+    /** @brief Only read with the timer trigger */
+    unsigned long delayOn = 0;
+    unsigned long delayOff = 0;
+    /** @brief Only read with the pattern trigger */
+    Pattern pattern;
+};
+
+/** @brief Selects the Physical constructor that leaves sysfs alone until
+ *         the LED is first used
+ */
+struct LazyProbe
+{
+    explicit LazyProbe() = default;
+};
+inline constexpr LazyProbe lazyProbe{};
+
 /** @class Physical
  *  @brief Responsible for applying actions on a particular physical LED
  */
@@ -26,7 +64,7 @@ class Physical : public PhysicalIfaces
 {
   public:
     Physical() = delete;
-    ~Physical() override = default;
+    ~Physical() override;
     Physical(const Physical&) = delete;
     Physical& operator=(const Physical&) = delete;
     Physical(Physical&&) = delete;
@@ -59,6 +97,49 @@ class Physical : public PhysicalIfaces
         emit_object_added();
     }
 
+    /** @brief Constructs LED object from settings already read, so that
+     *   the sysfs reads can happen elsewhere.
+     *
+     * @param[in] bus       - system dbus handler
+     * @param[in] objPath   - The Dbus path that hosts physical LED
+     * @param[in] led       - sysfs LED, as read into snapshot
+     * @param[in] snapshot  - settings read by probe()
+     * @param[in] color     - led color name
+     */
+    Physical(sdbusplus::bus_t& bus, const std::string& objPath, SysfsLed& led,
+             const Snapshot& snapshot, const std::string& color = "") :
+        PhysicalIfaces(bus, objPath.c_str(),
+                       PhysicalIfaces::action::defer_emit),
+        led(led)
+    {
+        apply(snapshot);
+        setLedColor(color);
+        emit_object_added();
+    }
+
+    /** @brief Constructs LED object with placeholder properties. Sysfs is
+     *   first read, and the object announced, on the first Get or Set of
+     *   a property or on ensureProbed(), whichever comes first.
+     *
+     * @param[in] bus       - system dbus handler
+     * @param[in] objPath   - The Dbus path that hosts physical LED
+     * @param[in] led       - sysfs LED
+     * @param[in] onProbed  - invoked once sysfs has been read
+     * @param[in] color     - led color name
+     */
+    Physical(sdbusplus::bus_t& bus, const std::string& objPath, SysfsLed& led,
+             LazyProbe, std::function<void()>&& onProbed,
+             const std::string& color = "") :
+        PhysicalIfaces(bus, objPath.c_str(),
+                       PhysicalIfaces::action::defer_emit),
+        led(led), probed(false), onProbed(std::move(onProbed))
+    {
+        setLedColor(color);
+    }
+
+    using PhysicalIfaces::dutyOn;
+    using PhysicalIfaces::period;
+
     /** @brief Overloaded State Property Setter function
      *
      *  @param[in] value   -  One of OFF / ON / BLINK
@@ -72,42 +153,324 @@ class Physical : public PhysicalIfaces
      */
     Action state() const override;
 
+    /** @brief Overriden DutyOn Property Getter function, reads sysfs first
+     *   if not done yet
+     */
+    uint8_t dutyOn() const override;
+
+    /** @brief Overriden DutyOn Property Setter function, reads sysfs first
+     *   if not done yet. A blinking LED gets its new delays right away.
+     */
+    uint8_t dutyOn(uint8_t value, bool skipSignal) override;
+
+    /** @brief Overriden Period Property Getter function, reads sysfs first
+     *   if not done yet
+     */
+    uint16_t period() const override;
+
+    /** @brief Overriden Period Property Setter function, reads sysfs first
+     *   if not done yet. A blinking LED gets its new delays right away.
+     */
+    uint16_t period(uint16_t value, bool skipSignal) override;
+
+    /** @brief Changes State, DutyOn and Period as a single request without
+     *   emitting PropertiesChanged, so that the caller can emit the
+     *   signals of many LEDs together. Fails like the State setter, in
+     *   which case no property changes.
+     *
+     *  @param[in] action - requested state
+     *  @param[in] dutyOn - requested duty cycle
+     *  @param[in] period - requested period
+     *  @return Names of the properties that changed
+     */
+    std::vector<std::string> update(Action action, uint8_t dutyOn,
+                                    uint16_t period);
+
+    /** @brief Reads sysfs and announces the object, unless already done.
+     *   Throws InternalFailure if sysfs cannot be read, to be retried on
+     *   the next call.
+     */
+    void ensureProbed();
+
+    /** @brief Whether sysfs has been read */
+    bool isProbed() const
+    {
+        return probed;
+    }
+
+    /** @brief Reloads the properties from sysfs after the LED may have
+     *         been changed by someone else. PropertiesChanged is only
+     *         emitted for values that actually differ.
+     */
+    void refresh();
+
+    /** @brief Moves sysfs accesses to a worker thread. State changes are
+     *         then acknowledged before they reach the LED, and a change the
+     *         LED rejects shows up as the property reverting.
+     *
+     *  @param[in] worker - worker to queue the accesses on
+     */
+    void setWorker(Worker& worker);
+
+    /** @brief Delays sysfs writes by a window in which further State
+     *         changes are merged. Only the state in effect when the window
+     *         closes is written, starting from what sysfs last received.
+     *
+     *  @param[in] event  - event loop running the window timer
+     *  @param[in] window - how long to collect changes for
+     */
+    void setCoalesceWindow(const sdeventplus::Event& event,
+                           std::chrono::milliseconds window);
+
+    /** @brief Makes Blink play a sequence through the kernel pattern
+     *         trigger instead of the timer trigger, so that complex
+     *         sequences repeat without any wakeup in this process. DutyOn
+     *         and Period have no effect while a pattern is set. Ignored if
+     *         the kernel lacks the pattern trigger.
+     *
+     *  @param[in] pattern - sequence, with brightness as a percentage of
+     *                       the maximum brightness
+     */
+    void setBlinkPattern(Pattern&& pattern);
+
+    /** @brief Blinks from the software engine rather than the kernel
+     *         timer trigger when the LED cannot blink in hardware, which
+     *         sysfs only tells when the timer trigger is missing, or when
+     *         forced to. A blink running on the timer trigger is handed
+     *         over to the engine.
+     *
+     *  @param[in] engine - software blink engine
+     *  @param[in] force  - use the engine even if the timer trigger exists
+     */
+    void setSoftBlink(SoftBlink& engine, bool force);
+
+    /** @brief Records every state that reaches sysfs, starting with the
+     *         current one, for a later instance to restore.
+     *
+     *  @param[in] journal - journal of this LED
+     */
+    void setJournal(Journal& journal);
+
+    /** @brief Writes the state collected in the coalescing window now */
+    void flush();
+
+    /** @brief Number of State changes that never reached sysfs because a
+     *         later one in the same coalescing window superseded them
+     */
+    unsigned long collapsedTransitions() const
+    {
+        return collapsed;
+    }
+
+    /** @brief Reads the settings of a LED from sysfs
+     *
+     *  @param[in] led - LED to read
+     *  @return The settings found
+     */
+    static Snapshot probe(SysfsLed& led);
+
   private:
+    /** @brief Sysfs values for a requested state, captured when the
+     *   request is made so they can be applied away from the event loop
+     */
+    struct Target
+    {
+        Action action;
+        /** @brief Brightness that asserts the LED */
+        unsigned long brightness;
+        uint8_t dutyOn;
+        uint16_t period;
+        /** @brief What drives the LED in this state */
+        Trigger trigger;
+        Brightness level;
+    };
+
+    using Timer = sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>;
+
     /** @brief Associated LED implementation
      */
     SysfsLed& led;
 
+    /** @brief State last written to, or read from, sysfs */
+    Target written{Action::Off, 0, 0, 0, Trigger::None, Brightness::Zero};
+
+    /** @brief Coalescing window and its timer, if coalescing */
+    std::chrono::milliseconds coalesceWindow{};
+    std::optional<Timer> coalesceTimer;
+
+    /** @brief Software blink engine, if this LED blinks from it. Only set
+     *   up at startup, like blinkPattern.
+     */
+    SoftBlink* softBlink = nullptr;
+
+    /** @brief Sequence played on Blink, brightness in percent. Only set
+     *   up at startup, so the worker may read it without locking.
+     */
+    Pattern blinkPattern;
+
+    /** @brief Sequence the pattern trigger was found playing, until the
+     *   LED is first written
+     */
+    std::optional<Pattern> foundPattern;
+
+    /** @brief State changes received in the current window */
+    unsigned long pending = 0;
+
+    /** @brief State changes merged away so far */
+    unsigned long collapsed = 0;
+
     /** @brief The value that will assert the LED */
     unsigned long assert{};
 
+    /** @brief Journal kept up to date, if any */
+    Journal* journal = nullptr;
+
+    /** @brief Worker running the sysfs accesses, if any */
+    Worker* worker = nullptr;
+
+    /** @brief Whether the properties hold what sysfs has */
+    bool probed = true;
+
+    /** @brief Invoked once a lazily constructed object read sysfs */
+    std::function<void()> onProbed;
+
+    /** @brief Lets completions tell whether this object still exists */
+    std::shared_ptr<bool> alive = std::make_shared<bool>(true);
+
+    /** @brief Implements the State setter
+     *
+     *  @param[in] value      - requested state
+     *  @param[in] skipSignal - whether to leave PropertiesChanged out
+     */
+    Action changeState(Action value, bool skipSignal);
+
+    /** @brief Applies new blink timing if the LED blinks, throwing like
+     *   the State setter
+     *
+     *  @param[in] request - blink with the new timing
+     */
+    void retime(const Target& request);
+
+    /** @brief Programs a state outside of the coalescing window, throwing
+     *   Unavailable or InternalFailure if it cannot
+     *
+     *  @param[in] request - state to program
+     */
+    void commit(const Target& request);
+
+    /** @brief Whether only the timing of a blink changes
+     *
+     *  @param[in] current - state last written
+     *  @param[in] request - requested state
+     */
+    static bool retimed(const Target& current, const Target& request);
+
+    /** @brief Whether a write planned for a transition can be left out
+     *
+     *  @param[in] write   - planned write
+     *  @param[in] current - state last written
+     *  @param[in] request - requested state
+     */
+    static bool unchanged(Write write, const Target& current,
+                          const Target& request);
+
+    /** @brief Whether a transition takes any write to sysfs
+     *
+     *  @param[in] current - state last written
+     *  @param[in] request - requested state
+     */
+    static bool needsWrites(const Target& current, const Target& request);
+
     /** @brief reads sysfs and then setsup the parameteres accordingly
      *
      *  @return None
      */
     void setInitialState();
 
+    /** @brief Sets the properties from settings read from sysfs
+     *
+     *  @param[in] snapshot - settings read by probe()
+     */
+    void apply(const Snapshot& snapshot);
+
+    /** @brief Captures the sysfs values for a requested state
+     *
+     *  @param[in] action - requested state
+     */
+    Target target(Action action) const;
+
+    /** @brief Brings sysfs from the state last written to the requested
+     *   one, through the worker if there is one
+     *
+     *  @param[in] request - state to program
+     *  @return false if the worker queue is full
+     */
+    bool program(const Target& request);
+
+    /** @brief Hands a blink request to the software engine
+     *
+     *  @param[in] request - blink to run, the LED having no trigger set
+     */
+    void startSoftBlink(const Target& request);
+
+    /** @brief Queues a sysfs access on the worker. Failures are logged and
+     *   followed by a refresh instead of calling then.
+     *
+     *  @param[in] job  - sysfs access, run on the worker thread
+     *  @param[in] then - run on the event loop once job succeeded
+     *  @return false if the worker queue is full
+     */
+    bool submit(Worker::Job&& job, std::function<void()>&& then);
+
+    /** @brief Writes a state that sysfs now holds to the journal
+     *
+     *  @param[in] state - state in sysfs
+     */
+    void record(const Target& state);
+
+    /** @brief Reloads the properties after a failed asynchronous access */
+    void refreshAfterError();
+
     /** @brief Applies the user triggered action on the LED
-     *   by writing to sysfs
+     *   by writing to sysfs, only what the transition table says it needs
      *
-     *  @param [in] current - Current state of LED
+     *  @param [in] current - State last written to the LED
      *  @param [in] request - Requested state
      *
      *  @return None
      */
-    void driveLED(Action current, Action request);
+    void driveLED(const Target& current, const Target& request);
 
-    /** @brief Sets the LED to either ON or OFF state
+    /** @brief Issues one write of a transition
      *
-     *  @param [in] action - Requested action. Could be OFF or ON
+     *  @param [in] write   - what to write
+     *  @param [in] request - Requested state
      *  @return None
      */
-    void stableStateOperation(Action action);
+    void perform(Write write, const Target& request);
+
+    /** @brief Tells how a requested state is to be driven */
+    static Goal goal(const Target& request);
 
-    /** @brief Sets the LED to BLINKING
+    /** @brief Computes delay_on and delay_off for a blink request
      *
-     *  @return None
+     *  @param [in] request - Requested state with its blink parameters
+     *  @return On and off times in milliseconds
+     */
+    static std::pair<unsigned long, unsigned long>
+        blinkDelays(const Target& request);
+
+    /** @brief The blink pattern as written to sysfs
+     *
+     *  @param[in] brightness - brightness at 100%
+     */
+    Pattern scaledPattern(unsigned long brightness) const;
+
+    /** @brief Tells whether the pattern found in sysfs is the one to
+     *   blink with. Otherwise it counts as a foreign trigger, so the next
+     *   blink writes the pattern again.
      */
-    void blinkOperation();
+    void matchPattern();
 
     /** @brief set led color property in DBus
      *
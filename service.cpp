@@ -0,0 +1,888 @@
+#include "service.hpp"
+
+#include "state.hpp"
+
+#include <systemd/sd-bus.h>
+#include <systemd/sd-daemon.h>
+
+#include <sdbusplus/message.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+#include <boost/algorithm/string.hpp>
+
+#include <time.h>
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace phosphor
+{
+namespace led
+{
+void getLedDescr(const std::string& name, LedDescr& ledDescr)
+{
+    std::vector<std::string> words;
+    boost::split(words, name, boost::is_any_of(":"));
+    try
+    {
+        ledDescr.devicename = words.at(0);
+        ledDescr.color = words.at(1);
+        ledDescr.function = words.at(2);
+    }
+    catch (const std::out_of_range&)
+    {
+        return;
+    }
+}
+
+std::string getDbusName(const LedDescr& ledDescr)
+{
+    std::vector<std::string> words;
+    words.emplace_back(ledDescr.devicename);
+    if (!ledDescr.function.empty())
+    {
+        words.emplace_back(ledDescr.function);
+    }
+    if (!ledDescr.color.empty())
+    {
+        words.emplace_back(ledDescr.color);
+    }
+    return boost::join(words, "_");
+}
+
+std::set<std::string> parsePhaseGroup(std::string_view list)
+{
+    std::vector<std::string> words;
+    boost::split(words, list, boost::is_any_of(","));
+
+    std::set<std::string> names;
+    for (auto& word : words)
+    {
+        if (word.empty())
+        {
+            throw std::invalid_argument("Empty LED name in phase group");
+        }
+        names.insert(std::move(word));
+    }
+    return names;
+}
+
+Service::Service(sdbusplus::bus_t& bus, const sdeventplus::Event& event,
+                 Options&& options) :
+    bus(bus), event(event), options(std::move(options)), wheel(event),
+    softBlink(wheel)
+{
+    if (this->options.async)
+    {
+        worker.emplace(event, asyncQueueDepth);
+    }
+
+    if (this->options.sharedName)
+    {
+        // Every LED is found with one GetManagedObjects on one name, and
+        // changed with one call
+        sharedManager.emplace(bus, objParent);
+        batch.emplace(bus, objParent, batchInterface, batchVtable, this);
+    }
+
+    // Left behind by an instance that exited while idle
+    restored = loadState(stateFile);
+    restoring = !restored.empty();
+    std::error_code ec;
+    std::filesystem::remove(stateFile, ec);
+
+    if (this->options.idleExit)
+    {
+        idleTimer.emplace(event, [this](Timer&) { idleTimeout(); });
+        idleTimer->restartOnce(*this->options.idleExit);
+
+        sd_bus_slot* slot = nullptr;
+        auto r = sd_bus_add_filter(bus.get(), &slot, &Service::activity, this);
+        if (r < 0)
+        {
+            throw std::system_error(-r, std::generic_category(),
+                                    "sd_bus_add_filter");
+        }
+        filterSlot.reset(slot);
+    }
+
+    uint64_t usec = 0;
+    if (sd_watchdog_enabled(0, &usec) > 0)
+    {
+        watchdogLimit = std::chrono::microseconds(usec);
+        watchdogTimer.emplace(
+            event, [this](Timer&) { watchdog(); },
+            std::chrono::duration_cast<Timer::Duration>(watchdogLimit / 2));
+    }
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+const sdbusplus::vtable_t Service::batchVtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::method("SetStates", "a(ssyq)", "", &Service::setStates),
+    sdbusplus::vtable::end(),
+};
+
+/** @brief Derives the D-Bus name of a LED from its sysfs name
+ *
+ *  @param[in] name      - LED name in sysfs
+ *  @param[out] ledDescr - LED description
+ *  @return              - DBus LED name
+ */
+static std::string dbusName(std::string name, LedDescr& ledDescr)
+{
+    // Convert to lowercase just in case some are not and that
+    // we follow lowercase all over
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    // LED names may have a hyphen and that would be an issue for
+    // dbus paths and hence need to convert them to underscores.
+    std::replace(name.begin(), name.end(), '-', '_');
+
+    // Convert LED name in sysfs into DBus name
+    getLedDescr(name, ledDescr);
+    return getDbusName(ledDescr);
+}
+
+bool Service::add(const std::filesystem::path& path)
+{
+    LedDescr ledDescr;
+    auto name = dbusName(path.filename().string(), ledDescr);
+
+    if (leds.contains(name))
+    {
+        return false;
+    }
+
+    auto led = makeLed(path, ledDescr.color);
+    if (auto saved = restore(path.filename().string(), *led))
+    {
+        publish(name, *led, saved);
+    }
+    else if (options.lazy)
+    {
+        publish(name, *led, std::nullopt);
+        probeWhenIdle();
+    }
+    else
+    {
+        publish(name, *led, Physical::probe(*led->sysfs));
+    }
+    leds.emplace(std::move(name), std::move(led));
+    return true;
+}
+
+size_t Service::addAll(const std::filesystem::path& dir)
+{
+    if (probing == 0)
+    {
+        probeStart = std::chrono::steady_clock::now();
+        published = 0;
+    }
+
+    // LEDs behind the same device are probed one after the other, as
+    // their accesses would queue up on its bus anyway.
+    std::map<std::filesystem::path, std::vector<std::string>> groups;
+    size_t added = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec))
+    {
+        LedDescr ledDescr;
+        auto sysfsName = entry.path().filename().string();
+        auto name = dbusName(sysfsName, ledDescr);
+        if (leds.contains(name))
+        {
+            continue;
+        }
+
+        auto led = makeLed(entry.path(), ledDescr.color);
+        if (auto saved = restore(sysfsName, *led))
+        {
+            try
+            {
+                publish(name, *led, saved);
+                leds.emplace(std::move(name), std::move(led));
+                ++added;
+                ++published;
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Failed to serve " << entry.path() << ": "
+                          << e.what() << std::endl;
+            }
+            continue;
+        }
+
+        groups[led->parent].emplace_back(name);
+
+        // Held here until probed, so that a second add() finds it
+        leds.emplace(std::move(name), std::move(led));
+    }
+    if (ec)
+    {
+        std::cerr << "Failed to list " << dir << ": " << ec.message()
+                  << std::endl;
+    }
+
+    if (options.lazy)
+    {
+        // Nothing to wait for, sysfs is read once the LEDs get used
+        for (const auto& [parent, names] : groups)
+        {
+            for (const auto& name : names)
+            {
+                try
+                {
+                    publish(name, *leds.at(name), std::nullopt);
+                    ++added;
+                    ++published;
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Failed to serve " << name << ": "
+                              << e.what() << std::endl;
+                    leds.erase(name);
+                }
+            }
+        }
+        probeWhenIdle();
+        groups.clear();
+    }
+
+    for (const auto& [parent, names] : groups)
+    {
+        if (probers.size() < maxProbers)
+        {
+            probers.emplace_back(
+                std::make_unique<Worker>(event, probeQueueDepth));
+        }
+        auto& prober = *probers[nextProber++ % probers.size()];
+
+        for (const auto& name : names)
+        {
+            auto* sysfs = leds.at(name)->sysfs.get();
+            auto id = leds.at(name)->id;
+            auto snapshot = std::make_shared<Snapshot>();
+            auto queued = prober.submit(
+                [sysfs, snapshot]() { *snapshot = Physical::probe(*sysfs); },
+                [this, name, id, snapshot](std::exception_ptr error) {
+                    probed(name, id, *snapshot, error);
+                });
+            if (queued)
+            {
+                ++probing;
+                ++added;
+                continue;
+            }
+
+            // Too many at once, this one waits for its own probe
+            try
+            {
+                publish(name, *leds.at(name), Physical::probe(*sysfs));
+                ++added;
+                ++published;
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Failed to serve " << name << ": " << e.what()
+                          << std::endl;
+                leds.erase(name);
+            }
+        }
+    }
+
+    if (probing == 0)
+    {
+        reportReady();
+    }
+    return added;
+}
+
+auto Service::makeLed(const std::filesystem::path& path,
+                      const std::string& color) -> std::unique_ptr<Led>
+{
+    auto led = std::make_unique<Led>();
+    led->id = ++lastId;
+#ifdef HAVE_IO_URING
+    led->sysfs =
+        std::make_unique<UringSysfsLed>(std::filesystem::path(path), uring);
+#else
+    led->sysfs = std::make_unique<SysfsLed>(std::filesystem::path(path));
+#endif
+    led->color = color;
+
+    if (options.journal)
+    {
+        try
+        {
+            led->journal = std::make_unique<Journal>(
+                std::filesystem::path(journalDir) / path.filename());
+        }
+        catch (const std::system_error& e)
+        {
+            // Only costs a probe on the next start
+            std::cerr << "No journal for " << path << ": " << e.what()
+                      << std::endl;
+        }
+    }
+
+    // LEDs of the same device share its bus
+    std::error_code noDevice;
+    led->parent = std::filesystem::canonical(path / "device", noDevice);
+    if (noDevice)
+    {
+        led->parent = path;
+    }
+    return led;
+}
+
+void Service::publish(const std::string& name, Led& led,
+                      const std::optional<Snapshot>& snapshot)
+{
+    auto objPath = std::string(objParent) + '/' + name;
+    led.phaseLocked = options.phaseGroup.contains(name);
+
+    if (options.legacyNames)
+    {
+        led.manager.emplace(bus, objPath.c_str());
+    }
+    if (snapshot)
+    {
+        led.physical = std::make_unique<Physical>(bus, objPath, *led.sysfs,
+                                                  *snapshot, led.color);
+        configure(led);
+    }
+    else
+    {
+        led.physical = std::make_unique<Physical>(
+            bus, objPath, *led.sysfs, lazyProbe,
+            [this, &led]() { configure(led); }, led.color);
+    }
+
+    // Unique bus name representing a single LED.
+    if (options.legacyNames)
+    {
+        led.busName = std::string(busParent) + '.' + name;
+        bus.request_name(led.busName.c_str());
+    }
+}
+
+void Service::configure(Led& led)
+{
+    auto& physical = *led.physical;
+    if (worker)
+    {
+        physical.setWorker(*worker);
+    }
+
+    // The engine anchors every blink on the same clock, which is what
+    // keeps the group in phase. A pattern would take the LED off it.
+    physical.setSoftBlink(softBlink, options.softBlink || led.phaseLocked);
+    if (!options.pattern.empty() && !led.phaseLocked)
+    {
+        physical.setBlinkPattern(Pattern(options.pattern));
+    }
+    if (led.journal)
+    {
+        physical.setJournal(*led.journal);
+    }
+    if (options.coalesce)
+    {
+        physical.setCoalesceWindow(event, *options.coalesce);
+    }
+
+    // Keep the properties in line with brightness changes made by the
+    // hardware. Changes written by other tools are not notified.
+    led.monitor = std::make_unique<Monitor>(
+        event, led.sysfs->path(), [&physical]() { physical.refresh(); });
+}
+
+void Service::probed(const std::string& name, uint64_t id,
+                     const Snapshot& snapshot, std::exception_ptr error)
+{
+    --probing;
+
+    // Removed while being probed, the LED only waited for its probe. One
+    // added again meanwhile under the same name has an id of its own.
+    auto it = leds.find(name);
+    if (removed.erase(id) == 0 && it != leds.end() && it->second->id == id)
+    {
+        try
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+            publish(name, *it->second, snapshot);
+            ++published;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to serve " << name << ": " << e.what()
+                      << std::endl;
+            leds.erase(it);
+        }
+    }
+
+    if (probing != 0)
+    {
+        return;
+    }
+
+    reportReady();
+
+    // The probers cannot go from within their own completion
+    reap.emplace(event, [this](sdeventplus::source::EventBase&) {
+        if (probing == 0)
+        {
+            probers.clear();
+        }
+    });
+}
+
+int Service::setStates(sd_bus_message* msg, void* data, sd_bus_error* error)
+{
+    auto* service = static_cast<Service*>(data);
+    try
+    {
+        sdbusplus::message_t m(msg);
+        std::vector<StateRequest> requests;
+        m.read(requests);
+
+        auto changes = service->applyStates(requests);
+        m.new_method_return().method_return();
+
+        // Signals follow the reply, all at once
+        for (const auto& [path, names] : changes)
+        {
+            service->bus.emit_properties_changed(
+                path.c_str(),
+                sdbusplus::xyz::openbmc_project::Led::server::Physical::
+                    interface,
+                names);
+        }
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return e.set_error(error);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Failed to set LED states: " << e.what() << std::endl;
+        using sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+        return InternalFailure().set_error(error);
+    }
+    return 1;
+}
+
+auto Service::applyStates(const std::vector<StateRequest>& requests)
+    -> std::vector<std::pair<std::string, std::vector<std::string>>>
+{
+    using Action = Physical::Action;
+    using sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+    using sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
+
+    struct Item
+    {
+        const std::string* name;
+        Led* led;
+        Action action;
+        uint8_t dutyOn;
+        uint16_t period;
+    };
+
+    // Nothing is applied unless the whole request makes sense
+    std::vector<Item> items;
+    items.reserve(requests.size());
+    for (const auto& [name, state, dutyOn, period] : requests)
+    {
+        auto it = leds.find(name);
+        if (it == leds.end() || it->second->physical == nullptr)
+        {
+            std::cerr << "Unknown LED " << name << std::endl;
+            throw InvalidArgument();
+        }
+        try
+        {
+            items.push_back({&it->first, it->second.get(),
+                             Physical::convertActionFromString(state), dutyOn,
+                             period});
+        }
+        catch (const sdbusplus::exception::InvalidEnumString&)
+        {
+            throw InvalidArgument();
+        }
+    }
+
+    // Writes to one device follow each other, and requests for the same
+    // LED keep their order
+    std::stable_sort(items.begin(), items.end(),
+                     [](const Item& a, const Item& b) {
+                         return a.led->parent < b.led->parent;
+                     });
+
+    std::vector<std::pair<std::string, std::vector<std::string>>> changes;
+    bool failed = false;
+    for (const auto& item : items)
+    {
+        try
+        {
+            auto names = item.led->physical->update(item.action, item.dutyOn,
+                                                    item.period);
+            if (!names.empty())
+            {
+                changes.emplace_back(std::string(objParent) + '/' + *item.name,
+                                     std::move(names));
+            }
+        }
+        catch (const sdbusplus::exception_t&)
+        {
+            // The others still get their change
+            failed = true;
+        }
+    }
+
+    if (failed)
+    {
+        for (const auto& [path, names] : changes)
+        {
+            bus.emit_properties_changed(
+                path.c_str(),
+                sdbusplus::xyz::openbmc_project::Led::server::Physical::
+                    interface,
+                names);
+        }
+        throw InternalFailure();
+    }
+    return changes;
+}
+
+void Service::reportReady()
+{
+    timespec boot{};
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    auto sinceBoot = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::seconds(boot.tv_sec) +
+        std::chrono::nanoseconds(boot.tv_nsec));
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - probeStart);
+    std::cerr << "Published " << published << " LEDs in " << elapsed.count()
+              << "ms, " << sinceBoot.count() << "ms after boot" << std::endl;
+    if (restoring && elapsed > restoreBudget)
+    {
+        std::cerr << "Restoring saved state took over "
+                  << restoreBudget.count() << "ms" << std::endl;
+    }
+    restoring = false;
+
+    if (announced)
+    {
+        return;
+    }
+    announced = true;
+
+    // Requests queued by D-Bus activation are let in once every LED is
+    // there to answer them
+    if (options.sharedName)
+    {
+        bus.request_name(busParent);
+    }
+    sd_notify(0, "READY=1");
+}
+
+void Service::watchdog()
+{
+    // The event loop is running, but a thread may be stuck in a sysfs
+    // access that never returns. Let systemd restart us then.
+    bool stalled = worker && worker->stalled(watchdogLimit);
+    for (const auto& prober : probers)
+    {
+        stalled = stalled || prober->stalled(watchdogLimit);
+    }
+    if (stalled)
+    {
+        std::cerr << "Sysfs access stalled, not feeding the watchdog"
+                  << std::endl;
+        return;
+    }
+    sd_notify(0, "WATCHDOG=1");
+}
+
+std::optional<Snapshot> Service::restore(const std::string& sysfsName,
+                                         Led& led)
+{
+    std::optional<Snapshot> saved;
+    if (auto node = restored.extract(sysfsName))
+    {
+        saved = std::move(node.mapped());
+    }
+    else if (led.journal)
+    {
+        saved = led.journal->load();
+    }
+    if (!saved)
+    {
+        return std::nullopt;
+    }
+
+    // The trigger is kept by the LED core without asking the driver. If
+    // it is not what was saved, someone else took over the LED meanwhile.
+    try
+    {
+        if (led.sysfs->getTrigger() != saved->trigger)
+        {
+            return std::nullopt;
+        }
+    }
+    catch (const std::system_error&)
+    {
+        return std::nullopt;
+    }
+    return saved;
+}
+
+int Service::activity(sd_bus_message*, void* data, sd_bus_error*)
+{
+    auto* service = static_cast<Service*>(data);
+    service->idleTimer->restartOnce(*service->options.idleExit);
+    return 0;
+}
+
+void Service::idleTimeout()
+{
+    // Software blinking and probes in flight would stop with the process
+    if (softBlink.size() != 0 || probing != 0)
+    {
+        idleTimer->restartOnce(*options.idleExit);
+        return;
+    }
+
+    // From now on requests start a new instance through D-Bus activation.
+    // Those that reached this one before the name went are still answered.
+    sd_bus_release_name(bus.get(), busParent);
+    while (sd_bus_process(bus.get(), nullptr) > 0)
+    {}
+    sd_bus_flush(bus.get());
+
+    // One of them may have started something that would stop with the
+    // process, stay then
+    if (softBlink.size() != 0 || probing != 0)
+    {
+        bus.request_name(busParent);
+        idleTimer->restartOnce(*options.idleExit);
+        return;
+    }
+
+    // Let every write land before reading back what to save
+    for (auto& [name, led] : leds)
+    {
+        if (led->physical != nullptr)
+        {
+            led->physical->flush();
+        }
+    }
+    if (worker)
+    {
+        worker->flush();
+    }
+
+    SavedState state;
+    for (auto& [name, led] : leds)
+    {
+        if (led->physical == nullptr || !led->physical->isProbed())
+        {
+            continue;
+        }
+        try
+        {
+            state.emplace(led->sysfs->path().filename().string(),
+                          Physical::probe(*led->sysfs));
+        }
+        catch (const std::system_error& e)
+        {
+            std::cerr << "Not saving " << name << ": " << e.what()
+                      << std::endl;
+        }
+    }
+
+    try
+    {
+        saveState(stateFile, state);
+    }
+    catch (const std::exception& e)
+    {
+        // The next instance probes everything instead
+        std::cerr << "Failed to save state: " << e.what() << std::endl;
+    }
+
+    std::cerr << "Exiting after " << options.idleExit->count()
+              << "s without requests" << std::endl;
+    sd_notify(0, "STOPPING=1");
+    event.exit(0);
+}
+
+void Service::probeWhenIdle()
+{
+    if (idleProbe)
+    {
+        idleProbe->set_enabled(sdeventplus::source::Enabled::OneShot);
+        return;
+    }
+
+    idleProbe.emplace(event, [this](sdeventplus::source::EventBase& source) {
+        // One LED per turn, so that requests are never kept waiting long
+        auto it = leds.upper_bound(probeCursor);
+        while (it != leds.end() && (it->second->physical == nullptr ||
+                                    it->second->physical->isProbed()))
+        {
+            ++it;
+        }
+        if (it == leds.end())
+        {
+            probeCursor.clear();
+            return;
+        }
+
+        probeCursor = it->first;
+        try
+        {
+            it->second->physical->ensureProbed();
+        }
+        catch (const std::exception& e)
+        {
+            // Left for the first request to try again
+            std::cerr << "Failed to probe " << it->first << ": " << e.what()
+                      << std::endl;
+        }
+        source.set_enabled(sdeventplus::source::Enabled::OneShot);
+    });
+    idleProbe->set_priority(SD_EVENT_PRIORITY_IDLE);
+}
+
+bool Service::remove(const std::string& sysfsName)
+{
+    LedDescr ledDescr;
+    auto it = leds.find(dbusName(sysfsName, ledDescr));
+    if (it == leds.end())
+    {
+        return false;
+    }
+
+    if (it->second->physical == nullptr)
+    {
+        // Still being probed, the probe finishes with the LED before it
+        // goes. Its name is free for the LED to come back meanwhile.
+        auto id = it->second->id;
+        removed.emplace(id, std::move(it->second));
+        leds.erase(it);
+    }
+    else
+    {
+        if (!it->second->busName.empty())
+        {
+            // Nobody can reach the LED through its own name any more, then
+            // the objects go, with queued sysfs accesses finished first.
+            sd_bus_release_name(bus.get(), it->second->busName.c_str());
+        }
+        leds.erase(it);
+    }
+
+    // A LED coming back may not be in the state it left in
+    if (options.journal)
+    {
+        std::error_code ec;
+        std::filesystem::remove(std::filesystem::path(journalDir) / sysfsName,
+                                ec);
+    }
+    return true;
+}
+
+void Service::watchHotplug(std::chrono::milliseconds window)
+{
+    this->window = window;
+    settleTimer.emplace(event, [this](Timer&) { settle(); });
+    uevents.emplace(
+        event, "leds", [this](const Uevent& uevent) { hotplug(uevent); },
+        [this]() {
+            rescan = true;
+            if (!settleTimer->isEnabled())
+            {
+                settleTimer->restartOnce(this->window);
+            }
+        });
+}
+
+void Service::hotplug(const Uevent& uevent)
+{
+    auto& change = changes[std::string(uevent.name())];
+    if (uevent.action == "add")
+    {
+        change.added = true;
+    }
+    else if (uevent.action == "remove")
+    {
+        // A later add is for whatever device comes next
+        change.removed = true;
+        change.added = false;
+    }
+    else
+    {
+        return;
+    }
+
+    if (!settleTimer->isEnabled())
+    {
+        settleTimer->restartOnce(window);
+    }
+}
+
+void Service::settle()
+{
+    auto settled = std::exchange(changes, {});
+
+    if (std::exchange(rescan, false))
+    {
+        // Drop what vanished unnoticed, then pick up what appeared
+        std::vector<std::string> gone;
+        for (const auto& [name, led] : leds)
+        {
+            if (!std::filesystem::exists(led->sysfs->path()))
+            {
+                gone.emplace_back(led->sysfs->path().filename());
+            }
+        }
+        for (const auto& name : gone)
+        {
+            remove(name);
+        }
+        addAll();
+    }
+
+    for (const auto& [name, change] : settled)
+    {
+        if (change.removed)
+        {
+            remove(name);
+        }
+        if (change.added)
+        {
+            try
+            {
+                add(std::filesystem::path(devParent) / name);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Failed to serve " << name << ": " << e.what()
+                          << std::endl;
+            }
+        }
+    }
+}
+
+} // namespace led
+} // namespace phosphor
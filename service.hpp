@@ -0,0 +1,394 @@
+#pragma once
+
+#include "journal.hpp"
+#include "monitor.hpp"
+#include "physical.hpp"
+#include "softblink.hpp"
+#include "sysfs.hpp"
+#include "timerwheel.hpp"
+#include "uevent.hpp"
+#include "worker.hpp"
+
+#ifdef HAVE_IO_URING
+#include "uring.hpp"
+#endif
+
+#include <systemd/sd-bus.h>
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/server/manager.hpp>
+#include <sdbusplus/vtable.hpp>
+#include <sdeventplus/clock.hpp>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/event.hpp>
+#include <sdeventplus/utility/timer.hpp>
+
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace phosphor
+{
+namespace led
+{
+struct LedDescr
+{
+    std::string devicename;
+    std::string color;
+    std::string function;
+};
+
+/** @brief parse LED name in sysfs
+ *  Parse sysfs LED name in format "devicename:colour:function"
+ *  or "devicename:colour" or "devicename" and sets corresponding
+ *  fields in LedDescr struct.
+ *
+ *  @param[in] name      - LED name in sysfs
+ *  @param[out] ledDescr - LED description
+ */
+void getLedDescr(const std::string& name, LedDescr& ledDescr);
+
+/** @brief generates LED DBus name from LED description
+ *
+ *  @param[in] name      - LED description
+ *  @return              - DBus LED name
+ */
+std::string getDbusName(const LedDescr& ledDescr);
+
+/** @brief Parses a comma separated list of D-Bus LED names
+ *
+ *  @param[in] list - e.g. "front_fault_amber,rear_fault_amber"
+ *  @return The names, throws std::invalid_argument if one is empty
+ */
+std::set<std::string> parsePhaseGroup(std::string_view list);
+
+/** @brief Settings applied to every LED of a Service */
+struct Options
+{
+    /** @brief Access sysfs from a worker thread */
+    bool async = false;
+    /** @brief Blink from the software engine even with the timer trigger */
+    bool softBlink = false;
+    /** @brief Sequence to blink with the pattern trigger, if not empty */
+    Pattern pattern;
+    /** @brief Window in which State changes are merged, if any */
+    std::optional<std::chrono::milliseconds> coalesce;
+    /** @brief Read sysfs on first use or when idle, not on add */
+    bool lazy = false;
+    /** @brief Serve every LED under busParent, managed at objParent */
+    bool sharedName = false;
+    /** @brief Claim busParent.<name> and manage objParent/<name> per LED */
+    bool legacyNames = true;
+    /** @brief Save state and exit after this long without D-Bus traffic.
+     *   Only with legacyNames off, as only busParent is activatable.
+     */
+    std::optional<std::chrono::seconds> idleExit;
+    /** @brief LEDs, by D-Bus name, blinking from the software engine so
+     *   that they stay in phase with each other
+     */
+    std::set<std::string> phaseGroup;
+    /** @brief Record the state of every LED under journalDir, so that a
+     *   new instance need not probe sysfs
+     */
+    bool journal = false;
+};
+
+/** @class Service
+ *  @brief Serves LEDs on D-Bus from a single event loop.
+ *
+ *  Each LED keeps the object path and bus name it had with one process per
+ *  LED, so that clients do not notice how many processes serve them. All
+ *  LEDs may also be served under one shared bus name, with or without the
+ *  per-LED names.
+ */
+class Service
+{
+  public:
+    static constexpr auto busParent = "xyz.openbmc_project.LED.Controller";
+    static constexpr auto objParent = "/xyz/openbmc_project/led/physical";
+    static constexpr auto devParent = "/sys/class/leds";
+
+    /** @brief Interface at objParent changing many LEDs in one call.
+     *
+     *  SetStates(a(ssyq)) takes the D-Bus name of each LED with the State,
+     *  DutyOn and Period to give it, all in one reply. Unknown LEDs or
+     *  states fail the call before anything is applied.
+     */
+    static constexpr auto batchInterface = "xyz.openbmc_project.Led.Controller";
+
+    Service() = delete;
+    ~Service() = default;
+    Service(const Service&) = delete;
+    Service& operator=(const Service&) = delete;
+    Service(Service&&) = delete;
+    Service& operator=(Service&&) = delete;
+
+    /** @brief Prepares to serve LEDs
+     *
+     *  @param[in] bus     - system dbus handler, attached to event
+     *  @param[in] event   - event loop serving the LEDs
+     *  @param[in] options - settings for every LED
+     */
+    Service(sdbusplus::bus_t& bus, const sdeventplus::Event& event,
+            Options&& options);
+
+    /** @brief Serves a LED and claims its legacy bus name
+     *
+     *  @param[in] path - sysfs directory of the LED
+     *  @return false if a LED with the same D-Bus name is already served
+     */
+    bool add(const std::filesystem::path& path);
+
+    /** @brief Serves every LED of a sysfs class directory. The LEDs are
+     *         probed on a few threads, one per parent device at a time,
+     *         and published from the event loop as their probe finishes.
+     *         LEDs that fail are logged and skipped.
+     *
+     *  @param[in] dir - directory holding the LEDs
+     *  @return Number of LEDs added or being probed
+     */
+    size_t addAll(const std::filesystem::path& dir = devParent);
+
+    /** @brief Stops serving a LED and releases its bus name
+     *
+     *  @param[in] sysfsName - name of the LED in the sysfs class directory
+     *  @return false if the LED was not served
+     */
+    bool remove(const std::string& sysfsName);
+
+    /** @brief Adds and removes LEDs as the kernel reports them through
+     *         uevents. Changes are applied once the window following the
+     *         first of them has passed, so that a burst of uevents from a
+     *         driver probe is handled in one go.
+     *
+     *  @param[in] window - how long to collect uevents for
+     */
+    void watchHotplug(std::chrono::milliseconds window = hotplugWindow);
+
+    /** @brief Number of LEDs served or being probed */
+    size_t size() const
+    {
+        return leds.size();
+    }
+
+  private:
+    /** @brief Everything serving one LED, in construction order */
+    struct Led
+    {
+        std::unique_ptr<SysfsLed> sysfs;
+        std::unique_ptr<Journal> journal;
+        std::optional<sdbusplus::server::manager_t> manager;
+        std::unique_ptr<Physical> physical;
+        std::unique_ptr<Monitor> monitor;
+        std::string busName;
+        std::string color;
+        /** @brief Device the LED belongs to, or the LED if unknown */
+        std::filesystem::path parent;
+        /** @brief Member of the phase group */
+        bool phaseLocked = false;
+        /** @brief Tells the LED from one added again under the same name */
+        uint64_t id = 0;
+    };
+
+    /** @brief LED name, State, DutyOn and Period given to SetStates */
+    using StateRequest = std::tuple<std::string, std::string, uint8_t, uint16_t>;
+
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+    static const sdbusplus::vtable_t batchVtable[];
+
+    /** @brief Handles SetStates */
+    static int setStates(sd_bus_message* msg, void* data, sd_bus_error* error);
+
+    /** @brief Applies SetStates requests, in order of parent device
+     *
+     *  @param[in] requests - what to apply
+     *  @return Properties changed on each object path, for the caller to
+     *          signal
+     */
+    std::vector<std::pair<std::string, std::vector<std::string>>>
+        applyStates(const std::vector<StateRequest>& requests);
+
+    /** @brief What a LED went through since the hotplug window opened */
+    struct Change
+    {
+        bool removed = false;
+        bool added = false;
+    };
+
+    using Timer = sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>;
+
+    /** @brief Where an instance exiting while idle leaves the LED state */
+    static constexpr auto stateFile = "/run/phosphor-led-sysfs/state";
+
+    /** @brief Where the journal of each LED is kept, by sysfs name */
+    static constexpr auto journalDir = "/run/phosphor-led-sysfs/journal";
+
+    /** @brief Expected bound on publishing restored LEDs, so that D-Bus
+     *   activation stays quick
+     */
+    static constexpr std::chrono::milliseconds restoreBudget{100};
+
+    /** @brief Depth of the queue shared by all LEDs in async mode */
+    static constexpr size_t asyncQueueDepth = 32;
+
+    /** @brief Default window for collecting uevents */
+    static constexpr std::chrono::milliseconds hotplugWindow{200};
+
+    /** @brief Most threads probing at startup */
+    static constexpr size_t maxProbers = 4;
+
+    /** @brief Depth of the queue of each prober */
+    static constexpr size_t probeQueueDepth = 256;
+
+    /** @brief Sets up a LED without touching sysfs yet
+     *
+     *  @param[in] path  - sysfs directory of the LED
+     *  @param[in] color - led color name
+     */
+    std::unique_ptr<Led> makeLed(const std::filesystem::path& path,
+                                 const std::string& color);
+
+    /** @brief Puts a LED on D-Bus and claims its bus name
+     *
+     *  @param[in] name     - D-Bus name of the LED
+     *  @param[in] led      - the LED
+     *  @param[in] snapshot - settings read from it, or nothing to read
+     *                        them on first use
+     */
+    void publish(const std::string& name, Led& led,
+                 const std::optional<Snapshot>& snapshot);
+
+    /** @brief Applies the options and watches a LED read from sysfs */
+    void configure(Led& led);
+
+    /** @brief Logs how long publishing the current batch took. The first
+     *   time, claims the shared name and tells systemd we are ready.
+     */
+    void reportReady();
+
+    /** @brief Feeds the systemd watchdog unless a thread is stuck */
+    void watchdog();
+
+    /** @brief Takes the settings saved for a LED on idle exit, or else
+     *   those in its journal, if they still hold
+     *
+     *  @param[in] sysfsName - name of the LED in the sysfs class directory
+     *  @param[in] led       - the LED
+     *  @return The saved settings, or nothing if the LED has to be probed
+     */
+    std::optional<Snapshot> restore(const std::string& sysfsName, Led& led);
+
+    /** @brief sd-bus filter seeing every incoming message */
+    static int activity(sd_bus_message* msg, void* data, sd_bus_error* error);
+
+    /** @brief Saves the state and exits, unless the LEDs need this process */
+    void idleTimeout();
+
+    /** @brief Has LEDs not used yet read from sysfs when there is
+     *   nothing else to do
+     */
+    void probeWhenIdle();
+
+    /** @brief Publishes a LED once its probe finished
+     *
+     *  @param[in] name     - D-Bus name of the LED
+     *  @param[in] id       - id of the LED probed, to tell it from a
+     *                         replacement
+     *  @param[in] snapshot - settings read from it
+     *  @param[in] error    - exception thrown by the probe, if any
+     */
+    void probed(const std::string& name, uint64_t id, const Snapshot& snapshot,
+                std::exception_ptr error);
+
+    /** @brief Records a uevent and opens the window if needed */
+    void hotplug(const Uevent& uevent);
+
+    /** @brief Applies the changes collected in the window */
+    void settle();
+
+    sdbusplus::bus_t& bus;
+    sdeventplus::Event event;
+    Options options;
+
+    /** @brief Object manager and SetStates for all LEDs under the shared
+     *   name
+     */
+    std::optional<sdbusplus::server::manager_t> sharedManager;
+    std::optional<sdbusplus::server::interface_t> batch;
+
+    /** @brief Must outlive the LEDs that use them. The wheel carries
+     *   every software effect, SoftBlink included.
+     */
+    TimerWheel wheel;
+    SoftBlink softBlink;
+#ifdef HAVE_IO_URING
+    /** @brief One ring for the blink setups of every LED */
+    Uring uring;
+#endif
+    std::optional<Worker> worker;
+
+    /** @brief LEDs served, by D-Bus name */
+    std::map<std::string, std::unique_ptr<Led>> leds;
+    /** @brief Id given to the last LED made */
+    uint64_t lastId = 0;
+    /** @brief LEDs removed while being probed, by id. Kept until their
+     *   probe finished, as it still reads them.
+     */
+    std::map<uint64_t, std::unique_ptr<Led>> removed;
+
+    /** @brief Threads probing LEDs, and when they started on the
+     *   current batch. Declared after leds as they refer to them.
+     */
+    std::vector<std::unique_ptr<Worker>> probers;
+    size_t nextProber = 0;
+    size_t probing = 0;
+    size_t published = 0;
+    std::chrono::steady_clock::time_point probeStart;
+    std::optional<sdeventplus::source::Defer> reap;
+
+    /** @brief Lazy mode: reads the LEDs nobody used yet, one at a time in
+     *   name order, starting after probeCursor
+     */
+    std::optional<sdeventplus::source::Defer> idleProbe;
+    std::string probeCursor;
+
+    /** @brief Hotplug state, if watching */
+    std::chrono::milliseconds window{};
+    std::optional<Timer> settleTimer;
+    std::optional<UeventMonitor> uevents;
+
+    /** @brief Changes in the current window, by sysfs name */
+    std::map<std::string, Change> changes;
+
+    /** @brief Uevents were lost, sysfs has to be compared with leds */
+    bool rescan = false;
+
+    /** @brief Settings saved by the previous instance, by sysfs name */
+    std::map<std::string, Snapshot> restored;
+    bool restoring = false;
+
+    /** @brief Whether the initial LEDs have been published */
+    bool announced = false;
+
+    /** @brief Watchdog state, if systemd asked for it */
+    std::chrono::microseconds watchdogLimit{};
+    std::optional<Timer> watchdogTimer;
+
+    /** @brief Idle exit state, if enabled */
+    std::optional<Timer> idleTimer;
+    std::unique_ptr<sd_bus_slot, decltype(&sd_bus_slot_unref)> filterSlot{
+        nullptr, sd_bus_slot_unref};
+};
+
+} // namespace led
+} // namespace phosphor
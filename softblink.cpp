@@ -0,0 +1,105 @@
+#include "softblink.hpp"
+
+#include <unistd.h>
+
+#include <array>
+#include <charconv>
+#include <iostream>
+#include <system_error>
+
+namespace phosphor
+{
+namespace led
+{
+SoftBlink::SoftBlink(const sdeventplus::Event& event) :
+    own(std::make_unique<TimerWheel>(event)), wheel(*own)
+{}
+
+SoftBlink::SoftBlink(TimerWheel& wheel) : wheel(wheel) {}
+
+auto SoftBlink::phase(Clock::time_point now, Clock::duration on,
+                      Clock::duration off) -> Phase
+{
+    if (off == Clock::duration::zero())
+    {
+        return {true, Clock::time_point::max()};
+    }
+    if (on == Clock::duration::zero())
+    {
+        return {false, Clock::time_point::max()};
+    }
+
+    // steady_clock is CLOCK_MONOTONIC, whose origin anchors the cycles
+    auto period = on + off;
+    auto cycle = now - (now.time_since_epoch() % period);
+    auto into = now - cycle;
+    if (into < on)
+    {
+        return {true, cycle + on};
+    }
+    return {false, cycle + period};
+}
+
+void SoftBlink::start(const std::filesystem::path& root,
+                      unsigned long brightness, unsigned long delayOn,
+                      unsigned long delayOff)
+{
+    auto it = entries.find(root);
+    if (it == entries.end())
+    {
+        it = entries.emplace(root, std::make_unique<Entry>(*this, root)).first;
+    }
+
+    // The timer trigger blinks at 1Hz when given no delays, match it
+    if (delayOn == 0 && delayOff == 0)
+    {
+        delayOn = delayOff = 500;
+    }
+
+    auto& entry = *it->second;
+    entry.brightness = brightness;
+    entry.on = std::chrono::milliseconds(delayOn);
+    entry.off = std::chrono::milliseconds(delayOff);
+    entry.lit.reset();
+    update(entry, Clock::now());
+}
+
+void SoftBlink::stop(const std::filesystem::path& root)
+{
+    entries.erase(root);
+}
+
+void SoftBlink::update(Entry& entry, Clock::time_point now)
+{
+    auto [lit, next] = phase(now, entry.on, entry.off);
+    if (next == Clock::time_point::max())
+    {
+        entry.timer.cancel();
+    }
+    else
+    {
+        entry.timer.schedule(next);
+    }
+    if (entry.lit == lit)
+    {
+        return;
+    }
+
+    std::array<char, 32> buf{};
+    auto [end, ec] = std::to_chars(buf.data(), buf.data() + buf.size() - 1,
+                                   lit ? entry.brightness : 0UL);
+    *end++ = '\n';
+
+    int fd = entry.file.get(entry.root);
+    auto len = static_cast<size_t>(end - buf.data());
+    if (fd < 0 || pwrite(fd, buf.data(), len, 0) < 0)
+    {
+        std::cerr << "Failed to blink " << entry.root << ": "
+                  << std::generic_category().message(errno) << std::endl;
+        entry.file.reset();
+        return;
+    }
+    entry.lit = lit;
+}
+} // namespace led
+} // namespace phosphor
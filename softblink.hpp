@@ -0,0 +1,115 @@
+#pragma once
+
+#include "sysfs.hpp"
+#include "timerwheel.hpp"
+
+#include <sdeventplus/event.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+
+namespace phosphor
+{
+namespace led
+{
+/** @class SoftBlink
+ *  @brief Blinks LEDs from this process, for drivers that cannot blink on
+ *         their own.
+ *
+ *  Every blinking LED has a timer on a TimerWheel. Phases are aligned
+ *  on multiples of the period counted from the monotonic clock origin, so
+ *  LEDs with the same timing toggle together in one wakeup, and the timer
+ *  is disarmed while nothing blinks. The anchor is the same for every
+ *  process, so LEDs served by separate processes stay in phase as well.
+ */
+class SoftBlink
+{
+  public:
+    using Clock = TimerWheel::Clock;
+
+    SoftBlink() = delete;
+    SoftBlink(const SoftBlink&) = delete;
+    SoftBlink& operator=(const SoftBlink&) = delete;
+    SoftBlink(SoftBlink&&) = delete;
+    SoftBlink& operator=(SoftBlink&&) = delete;
+
+    /** @brief Creates an engine with a timer wheel of its own */
+    explicit SoftBlink(const sdeventplus::Event& event);
+
+    /** @brief Creates an engine sharing a timer wheel with other effects */
+    explicit SoftBlink(TimerWheel& wheel);
+
+    ~SoftBlink() = default;
+
+    /** @brief Starts blinking a LED, or changes how it blinks. The LED
+     *         should have no trigger set.
+     *
+     *  @param[in] root       - sysfs directory of the LED
+     *  @param[in] brightness - brightness while on
+     *  @param[in] delayOn    - on time in milliseconds
+     *  @param[in] delayOff   - off time in milliseconds
+     */
+    void start(const std::filesystem::path& root, unsigned long brightness,
+               unsigned long delayOn, unsigned long delayOff);
+
+    /** @brief Stops blinking a LED, leaving its brightness as it is */
+    void stop(const std::filesystem::path& root);
+
+    /** @brief Number of LEDs blinking */
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    /** @brief Where a blink cycle stands at some point in time */
+    struct Phase
+    {
+        bool lit;
+        /** @brief When the LED toggles next */
+        Clock::time_point next;
+    };
+
+    /** @brief Computes the phase of a blink at a given time
+     *
+     *  @param[in] now - point in time
+     *  @param[in] on  - on time
+     *  @param[in] off - off time
+     */
+    static Phase phase(Clock::time_point now, Clock::duration on,
+                       Clock::duration off);
+
+  private:
+    struct Entry
+    {
+        Entry(SoftBlink& engine, const std::filesystem::path& root) :
+            root(root), file("brightness"),
+            timer(engine.wheel, [this, &engine](Clock::time_point now) {
+                engine.update(*this, now);
+            })
+        {}
+
+        std::filesystem::path root;
+        /** @brief Own descriptor, SysfsLed may be in use on a worker */
+        SysfsAttr file;
+        unsigned long brightness = 0;
+        Clock::duration on{};
+        Clock::duration off{};
+        std::optional<bool> lit;
+        /** @brief Due at the next toggle, unscheduled while steady */
+        TimerWheel::Timer timer;
+    };
+
+    /** @brief Brings an entry to its current phase and schedules the next
+     *         toggle
+     */
+    void update(Entry& entry, Clock::time_point now);
+
+    std::unique_ptr<TimerWheel> own;
+    TimerWheel& wheel;
+    std::map<std::filesystem::path, std::unique_ptr<Entry>> entries;
+};
+} // namespace led
+} // namespace phosphor
@@ -0,0 +1,58 @@
+#include "state.hpp"
+
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+namespace phosphor
+{
+namespace led
+{
+void saveState(const std::filesystem::path& file, const SavedState& state)
+{
+    std::filesystem::create_directories(file.parent_path());
+
+    // One line per LED, fields as named in Snapshot
+    auto temp = file;
+    temp += ".new";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        for (const auto& [name, snapshot] : state)
+        {
+            out << name << ' ' << snapshot.maxBrightness << ' '
+                << snapshot.trigger << ' ' << snapshot.brightness << ' '
+                << snapshot.delayOn << ' ' << snapshot.delayOff << '\n';
+        }
+        out.flush();
+        if (!out)
+        {
+            throw std::system_error(EIO, std::generic_category(),
+                                    temp.string());
+        }
+    }
+    std::filesystem::rename(temp, file);
+}
+
+SavedState loadState(const std::filesystem::path& file)
+{
+    SavedState state;
+    std::ifstream in(file);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string name;
+        Snapshot snapshot;
+        fields >> name >> snapshot.maxBrightness >> snapshot.trigger >>
+            snapshot.brightness >> snapshot.delayOn >> snapshot.delayOff;
+        if (fields.fail())
+        {
+            continue;
+        }
+        state.emplace(std::move(name), std::move(snapshot));
+    }
+    return state;
+}
+} // namespace led
+} // namespace phosphor
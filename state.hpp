@@ -0,0 +1,32 @@
+#pragma once
+
+#include "physical.hpp"
+
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace phosphor
+{
+namespace led
+{
+/** @brief Settings of LEDs, by name in the sysfs class directory */
+using SavedState = std::map<std::string, Snapshot>;
+
+/** @brief Writes the settings of LEDs for a later instance to pick up.
+ *         The file is replaced atomically.
+ *
+ *  @param[in] file  - where to save, its directory is created if needed
+ *  @param[in] state - settings to save
+ */
+void saveState(const std::filesystem::path& file, const SavedState& state);
+
+/** @brief Reads settings saved by saveState()
+ *
+ *  @param[in] file - where they were saved
+ *  @return The settings, without the LEDs whose line is malformed, or
+ *          nothing if the file does not exist
+ */
+SavedState loadState(const std::filesystem::path& file);
+} // namespace led
+} // namespace phosphor
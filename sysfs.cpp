@@ -16,9 +16,18 @@
 
 #include "sysfs.hpp"
 
-#include <fstream>
-#include <iostream>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
 #include <string>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
 
 namespace fs = std::filesystem;
 
@@ -26,75 +35,501 @@ namespace phosphor
 {
 namespace led
 {
+SysfsAttr::~SysfsAttr()
+{
+    reset();
+}
+
+int SysfsAttr::get(const fs::path& root)
+{
+    if (fd < 0)
+    {
+        auto path = root / name;
+        fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0 && errno == EACCES)
+        {
+            // Read-only attributes such as max_brightness refuse O_RDWR
+            fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+    }
+    return fd;
+}
+
+void SysfsAttr::reset()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+}
+
+/** @brief Whether an I/O error means the attribute behind a cached descriptor
+ *         went away, in which case it is worth reopening it once.
+ */
+static bool isStale(int err)
+{
+    return err == ENODEV || err == ENOENT || err == ESTALE;
+}
+
+[[noreturn]] static void throwAttrError(int err, const SysfsAttr& attr)
+{
+    throw std::system_error(err, std::generic_category(), attr.name);
+}
+
+/** @brief Reads from offset of an attribute, reopening it once if stale
+ *
+ *  @return Number of bytes read, throws std::system_error on failure
+ */
+static size_t readAttr(const fs::path& root, SysfsAttr& attr, char* buf,
+                       size_t size, off_t offset)
+{
+    for (int attempt = 0;; ++attempt)
+    {
+        int fd = attr.get(root);
+        if (fd < 0)
+        {
+            throwAttrError(errno, attr);
+        }
+        ssize_t len = pread(fd, buf, size, offset);
+        if (len >= 0)
+        {
+            return static_cast<size_t>(len);
+        }
+        if (attempt > 0 || !isStale(errno))
+        {
+            throwAttrError(errno, attr);
+        }
+        attr.reset();
+    }
+}
+
+/** @brief Stores value, newline terminated, into an attribute, reopening it
+ *         once if stale
+ *
+ *  Sysfs consumes a store in a single write(2), so anything short of the
+ *  whole value is reported as an error rather than retried.
+ */
+static void writeAttr(const fs::path& root, SysfsAttr& attr,
+                      std::string_view value)
+{
+    static char newline = '\n';
+    std::array<iovec, 2> iov{{
+        {const_cast<char*>(value.data()), value.size()},
+        {&newline, 1},
+    }};
+    const auto size = static_cast<ssize_t>(value.size() + 1);
+
+    for (int attempt = 0;; ++attempt)
+    {
+        int fd = attr.get(root);
+        if (fd < 0)
+        {
+            throwAttrError(errno, attr);
+        }
+        ssize_t len = pwritev(fd, iov.data(), iov.size(), 0);
+        if (len >= 0)
+        {
+            if (len != size)
+            {
+                throwAttrError(EIO, attr);
+            }
+            return;
+        }
+        if (attempt > 0 || !isStale(errno))
+        {
+            throwAttrError(errno, attr);
+        }
+        attr.reset();
+    }
+}
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+Pattern parsePattern(std::string_view content)
+{
+    Pattern pattern;
+    const char* it = content.data();
+    const char* end = content.data() + content.size();
+    std::array<unsigned long, 2> pair{};
+    size_t n = 0;
+    while (true)
+    {
+        it = std::find_if_not(it, end, isSpace);
+        if (it == end)
+        {
+            break;
+        }
+        auto [next, ec] = std::from_chars(it, end, pair.at(n));
+        if (ec != std::errc() || (next != end && !isSpace(*next)))
+        {
+            throw std::invalid_argument("Malformed pattern");
+        }
+        it = next;
+        if (++n == pair.size())
+        {
+            pattern.push_back({pair[0], pair[1]});
+            n = 0;
+        }
+    }
+    if (n != 0)
+    {
+        throw std::invalid_argument("Pattern step without duration");
+    }
+    return pattern;
+}
+
+std::string formatPattern(const Pattern& pattern)
+{
+    std::string content;
+    std::array<char, 32> buf{};
+    for (const auto& step : pattern)
+    {
+        for (auto value : {step.brightness, step.duration})
+        {
+            auto [end, ec] =
+                std::to_chars(buf.data(), buf.data() + buf.size(), value);
+            if (!content.empty())
+            {
+                content += ' ';
+            }
+            content.append(buf.data(), end);
+        }
+    }
+    return content;
+}
+
+TriggerList parseTriggerList(std::string_view content)
+{
+    TriggerList list;
+    auto it = content.begin();
+    while (true)
+    {
+        auto first = std::find_if_not(it, content.end(), isSpace);
+        if (first == content.end())
+        {
+            break;
+        }
+        it = std::find_if(first, content.end(), isSpace);
+
+        std::string_view name{first, it};
+        if (name.size() > 2 && name.front() == '[' && name.back() == ']')
+        {
+            name = name.substr(1, name.size() - 2);
+            list.active = name;
+        }
+        list.available.emplace_back(name);
+    }
+
+    // A plain value without brackets names the trigger on its own
+    if (list.active.empty() && !list.available.empty())
+    {
+        list.active = list.available.front();
+    }
+
+    return list;
+}
+
 template <typename T>
-T getSysfsAttr(const fs::path& path);
+T getSysfsAttr(const fs::path& root, SysfsAttr& attr);
 
 template <>
-std::string getSysfsAttr(const fs::path& path)
+std::string getSysfsAttr(const fs::path& root, SysfsAttr& attr)
 {
+    // Some attributes, such as the trigger list, may exceed a page
     std::string content;
-    std::ifstream file(path);
-    file >> content;
+    std::array<char, 4096> buf{};
+    size_t len = 0;
+    do
+    {
+        len = readAttr(root, attr, buf.data(), buf.size(),
+                       static_cast<off_t>(content.size()));
+        content.append(buf.data(), len);
+    } while (len == buf.size());
+
     return content;
 }
 
 template <>
-unsigned long getSysfsAttr(const fs::path& path)
+unsigned long getSysfsAttr(const fs::path& root, SysfsAttr& attr)
 {
-    std::string content = getSysfsAttr<std::string>(path);
-    return std::strtoul(content.c_str(), nullptr, 0);
+    std::array<char, 32> buf{};
+    size_t len = readAttr(root, attr, buf.data(), buf.size(), 0);
+    if (len == buf.size())
+    {
+        // Cannot be a single number, the value got cut off
+        throwAttrError(EOVERFLOW, attr);
+    }
+
+    const char* first = std::find_if_not(buf.data(), buf.data() + len, isSpace);
+    const char* last = buf.data() + len;
+    unsigned long value = 0;
+    auto [end, ec] = std::from_chars(first, last, value);
+    if (ec != std::errc())
+    {
+        throwAttrError(static_cast<int>(ec), attr);
+    }
+    if (end != last && !isSpace(*end))
+    {
+        throwAttrError(EINVAL, attr);
+    }
+    return value;
 }
 
 template <typename T>
-void setSysfsAttr(const fs::path& path, const T& value)
+void setSysfsAttr(const fs::path& root, SysfsAttr& attr, const T& value);
+
+template <>
+void setSysfsAttr(const fs::path& root, SysfsAttr& attr,
+                  const std::string& value)
+{
+    writeAttr(root, attr, value);
+}
+
+template <>
+void setSysfsAttr(const fs::path& root, SysfsAttr& attr,
+                  const unsigned long& value)
 {
-    std::ofstream file(path);
-    file << value;
+    std::array<char, 32> buf{};
+    auto [end, ec] = std::to_chars(buf.data(), buf.data() + buf.size(), value);
+    if (ec != std::errc())
+    {
+        throwAttrError(static_cast<int>(ec), attr);
+    }
+    writeAttr(root, attr, {buf.data(), static_cast<size_t>(end - buf.data())});
 }
 
 unsigned long SysfsLed::getBrightness()
 {
-    return getSysfsAttr<unsigned long>(root / attrBrightness);
+    shadowBrightness = getSysfsAttr<unsigned long>(root, fileBrightness);
+    return *shadowBrightness;
 }
 
 void SysfsLed::setBrightness(unsigned long brightness)
 {
-    setSysfsAttr<unsigned long>(root / attrBrightness, brightness);
+    // With a trigger active the kernel owns brightness, so only trust the
+    // shadow while the trigger is known to be none.
+    if (shadowTrigger == "none" && shadowBrightness == brightness)
+    {
+        ++elided;
+        return;
+    }
+
+    shadowBrightness.reset();
+    setSysfsAttr<unsigned long>(root, fileBrightness, brightness);
+    shadowBrightness = brightness;
+
+    // Writing zero also removes any trigger
+    if (brightness == 0 && shadowTrigger != "none")
+    {
+        triggerChanged();
+        shadowTrigger = "none";
+        shadowBrightness = brightness;
+    }
 }
 
 unsigned long SysfsLed::getMaxBrightness()
 {
-    return getSysfsAttr<unsigned long>(root / attrMaxBrightness);
+    return getSysfsAttr<unsigned long>(root, fileMaxBrightness);
 }
 
 std::string SysfsLed::getTrigger()
 {
-    return getSysfsAttr<std::string>(root / attrTrigger);
+    std::string content;
+    try
+    {
+        content = getSysfsAttr<std::string>(root, fileTrigger);
+    }
+    catch (const std::system_error& e)
+    {
+        // Without CONFIG_LEDS_TRIGGERS there is no trigger attribute, and
+        // so no trigger either
+        if (e.code().value() != ENOENT)
+        {
+            throw;
+        }
+        availableTriggers.emplace();
+        shadowTrigger = "none";
+        return "none";
+    }
+
+    auto list = parseTriggerList(content);
+    availableTriggers = std::move(list.available);
+    shadowTrigger = list.active;
+    return list.active;
 }
 
 void SysfsLed::setTrigger(const std::string& trigger)
 {
-    setSysfsAttr<std::string>(root / attrTrigger, trigger);
+    if (shadowTrigger == trigger)
+    {
+        ++elided;
+        return;
+    }
+
+    shadowTrigger.reset();
+    triggerChanged();
+    try
+    {
+        setSysfsAttr<std::string>(root, fileTrigger, trigger);
+    }
+    catch (const std::system_error& e)
+    {
+        // An unknown trigger may have just been provided by a module
+        if (e.code().value() == EINVAL)
+        {
+            availableTriggers.reset();
+        }
+        throw;
+    }
+    shadowTrigger = trigger;
+}
+
+bool SysfsLed::hasTrigger(const std::string& trigger)
+{
+    if (!availableTriggers)
+    {
+        getTrigger();
+    }
+    return std::find(availableTriggers->begin(), availableTriggers->end(),
+                     trigger) != availableTriggers->end();
 }
 
 unsigned long SysfsLed::getDelayOn()
 {
-    return getSysfsAttr<unsigned long>(root / attrDelayOn);
+    shadowDelayOn = getSysfsAttr<unsigned long>(root, fileDelayOn);
+    return *shadowDelayOn;
 }
 
 void SysfsLed::setDelayOn(unsigned long ms)
 {
-    setSysfsAttr<unsigned long>(root / attrDelayOn, ms);
+    if (shadowDelayOn == ms)
+    {
+        ++elided;
+        return;
+    }
+
+    shadowDelayOn.reset();
+    setSysfsAttr<unsigned long>(root, fileDelayOn, ms);
+    shadowDelayOn = ms;
 }
 
 unsigned long SysfsLed::getDelayOff()
 {
-    return getSysfsAttr<unsigned long>(root / attrDelayOff);
+    shadowDelayOff = getSysfsAttr<unsigned long>(root, fileDelayOff);
+    return *shadowDelayOff;
 }
 
 void SysfsLed::setDelayOff(unsigned long ms)
 {
-    setSysfsAttr<unsigned long>(root / attrDelayOff, ms);
+    if (shadowDelayOff == ms)
+    {
+        ++elided;
+        return;
+    }
+
+    shadowDelayOff.reset();
+    setSysfsAttr<unsigned long>(root, fileDelayOff, ms);
+    shadowDelayOff = ms;
+}
+
+void SysfsLed::setBlink(unsigned long delayOn, unsigned long delayOff)
+{
+    setTrigger("timer");
+    setDelayOn(delayOn);
+    setDelayOff(delayOff);
+}
+
+void SysfsLed::setPattern(const Pattern& pattern)
+{
+    setTrigger("pattern");
+    if (shadowPattern == pattern)
+    {
+        ++elided;
+        return;
+    }
+
+    shadowPattern.reset();
+    auto content = formatPattern(pattern);
+    if (hwPatternSupported.value_or(true))
+    {
+        try
+        {
+            setSysfsAttr<std::string>(root, fileHwPattern, content);
+            hwPatternSupported = true;
+            shadowPattern = pattern;
+            return;
+        }
+        catch (const std::system_error& e)
+        {
+            // Missing without pattern_set in the driver, and refused when
+            // the driver cannot express this sequence.
+            auto err = e.code().value();
+            if (err != ENOENT && err != EINVAL && err != EOPNOTSUPP)
+            {
+                throw;
+            }
+            if (err == ENOENT)
+            {
+                hwPatternSupported = false;
+            }
+        }
+    }
+
+    setSysfsAttr<std::string>(root, filePattern, content);
+    shadowPattern = pattern;
+}
+
+Pattern SysfsLed::getPattern()
+{
+    // Each attribute only shows the sequence that was written to it
+    auto pattern = parsePattern(getSysfsAttr<std::string>(root, filePattern));
+    if (pattern.empty() && hwPatternSupported.value_or(true))
+    {
+        try
+        {
+            pattern =
+                parsePattern(getSysfsAttr<std::string>(root, fileHwPattern));
+        }
+        catch (const std::system_error& e)
+        {
+            if (e.code().value() != ENOENT)
+            {
+                throw;
+            }
+            hwPatternSupported = false;
+        }
+    }
+    shadowPattern = pattern;
+    return pattern;
+}
+
+void SysfsLed::invalidate()
+{
+    shadowBrightness.reset();
+    shadowTrigger.reset();
+    shadowDelayOn.reset();
+    shadowDelayOff.reset();
+    shadowPattern.reset();
+}
+
+void SysfsLed::triggerChanged()
+{
+    // The kernel recreates the trigger specific attributes whenever the
+    // trigger changes, which leaves any descriptor we hold on them dead.
+    fileDelayOn.reset();
+    fileDelayOff.reset();
+    filePattern.reset();
+    fileHwPattern.reset();
+    shadowDelayOn.reset();
+    shadowDelayOff.reset();
+    shadowPattern.reset();
+
+    // Dropping the old trigger also turns the LED off
+    shadowBrightness.reset();
 }
 } // namespace led
 } // namespace phosphor
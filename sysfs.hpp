@@ -16,11 +16,94 @@
 
 #pragma once
 #include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace phosphor
 {
 namespace led
 {
+/** @class SysfsAttr
+ *  @brief Holds a file descriptor on a single LED sysfs attribute so that it
+ *         can be reused across accesses instead of reopened every time.
+ */
+class SysfsAttr
+{
+  public:
+    explicit SysfsAttr(const char* name) : name(name)
+    {}
+    SysfsAttr() = delete;
+    SysfsAttr(const SysfsAttr& other) = delete;
+    SysfsAttr(SysfsAttr&& other) = delete;
+    SysfsAttr& operator=(const SysfsAttr& other) = delete;
+    SysfsAttr& operator=(SysfsAttr&& other) = delete;
+
+    ~SysfsAttr();
+
+    /** @brief Returns the cached descriptor, opening the attribute below
+     *         root if it is not open yet.
+     *
+     *  @param[in] root - sysfs directory of the LED
+     *  @return The descriptor, or -1 with errno set if the open failed
+     */
+    int get(const std::filesystem::path& root);
+
+    /** @brief Closes the cached descriptor so the next access reopens it.
+     *         Needed when the attribute was removed and recreated, like
+     *         delay_on and delay_off are whenever the trigger changes.
+     */
+    void reset();
+
+    /** @brief Attribute file name */
+    const char* const name;
+
+  private:
+    int fd = -1;
+};
+
+/** @brief Decoded content of the trigger attribute */
+struct TriggerList
+{
+    /** @brief Trigger currently in effect */
+    std::string active;
+    /** @brief Every trigger the kernel offers, in kernel order */
+    std::vector<std::string> available;
+};
+
+/** @brief One step of a pattern trigger sequence */
+struct PatternStep
+{
+    unsigned long brightness;
+    /** @brief Time in milliseconds to move to the next step's brightness */
+    unsigned long duration;
+
+    bool operator==(const PatternStep&) const = default;
+};
+
+/** @brief Sequence played, and repeated, by the pattern trigger */
+using Pattern = std::vector<PatternStep>;
+
+/** @brief Parses a pattern as the kernel formats it: whitespace separated
+ *         brightness and duration pairs, e.g. "255 100 0 900".
+ *
+ *  @param[in] content - pattern text
+ *  @return The steps, throws std::invalid_argument if malformed
+ */
+Pattern parsePattern(std::string_view content);
+
+/** @brief Formats a pattern the way the kernel expects it */
+std::string formatPattern(const Pattern& pattern);
+
+/** @brief Parses the trigger attribute, e.g. "none [timer] heartbeat", where
+ *         the kernel brackets the active trigger.
+ *
+ *  @param[in] content - attribute content
+ *  @return The active and available triggers
+ */
+TriggerList parseTriggerList(std::string_view content);
+
 class SysfsLed
 {
   public:
@@ -34,24 +117,100 @@ class SysfsLed
 
     virtual ~SysfsLed() = default;
 
+    /** @brief sysfs directory of the LED */
+    const std::filesystem::path& path() const
+    {
+        return root;
+    }
+
     virtual unsigned long getBrightness();
     virtual void setBrightness(unsigned long brightness);
     virtual unsigned long getMaxBrightness();
     virtual std::string getTrigger();
     virtual void setTrigger(const std::string& trigger);
+
+    /** @brief Whether the kernel offers a trigger. The available triggers
+     *         only change on module load, so they are read once and cached.
+     *
+     *  @param[in] trigger - trigger name
+     */
+    virtual bool hasTrigger(const std::string& trigger);
+
+    /** @brief Starts the timer trigger with the given delays. The trigger
+     *         must be selected before its delay attributes appear, so the
+     *         writes are issued in that order.
+     *
+     *  @param[in] delayOn  - on time in milliseconds
+     *  @param[in] delayOff - off time in milliseconds
+     */
+    virtual void setBlink(unsigned long delayOn, unsigned long delayOff);
+
+    /** @brief Hands a whole sequence to the pattern trigger, which repeats
+     *         it in the kernel. The sequence goes to hw_pattern when the
+     *         driver accepts it there, so the LED hardware runs it itself.
+     *
+     *  @param[in] pattern - sequence to play, brightness in sysfs units
+     */
+    virtual void setPattern(const Pattern& pattern);
+
+    /** @brief Reads the sequence played by the pattern trigger */
+    virtual Pattern getPattern();
     virtual unsigned long getDelayOn();
     virtual void setDelayOn(unsigned long ms);
     virtual unsigned long getDelayOff();
     virtual void setDelayOff(unsigned long ms);
 
+    /** @brief Forgets the values last written to or read from sysfs, so the
+     *         next write of every attribute reaches the kernel. Must be
+     *         called when the LED may have been changed behind our back.
+     */
+    virtual void invalidate();
+
+    /** @brief Number of writes skipped because the attribute already held
+     *         the requested value
+     */
+    unsigned long elidedWrites() const
+    {
+        return elided;
+    }
+
   protected:
     static constexpr const char* attrBrightness = "brightness";
     static constexpr const char* attrMaxBrightness = "max_brightness";
     static constexpr const char* attrTrigger = "trigger";
     static constexpr const char* attrDelayOn = "delay_on";
     static constexpr const char* attrDelayOff = "delay_off";
+    static constexpr const char* attrPattern = "pattern";
+    static constexpr const char* attrHwPattern = "hw_pattern";
 
     std::filesystem::path root;
+
+    SysfsAttr fileBrightness{attrBrightness};
+    SysfsAttr fileMaxBrightness{attrMaxBrightness};
+    SysfsAttr fileTrigger{attrTrigger};
+    SysfsAttr fileDelayOn{attrDelayOn};
+    SysfsAttr fileDelayOff{attrDelayOff};
+    SysfsAttr filePattern{attrPattern};
+    SysfsAttr fileHwPattern{attrHwPattern};
+
+    /** @brief Last known content of each attribute, if any */
+    std::optional<unsigned long> shadowBrightness;
+    std::optional<std::string> shadowTrigger;
+    std::optional<unsigned long> shadowDelayOn;
+    std::optional<unsigned long> shadowDelayOff;
+    std::optional<Pattern> shadowPattern;
+
+    /** @brief Whether the driver runs patterns itself, once known */
+    std::optional<bool> hwPatternSupported;
+
+    /** @brief Cached list of triggers offered by the kernel */
+    std::optional<std::vector<std::string>> availableTriggers;
+
+    /** @brief Count of writes skipped thanks to the shadow values */
+    unsigned long elided = 0;
+
+    /** @brief Accounts for the kernel side effects of a trigger change */
+    void triggerChanged();
 };
 } // namespace led
 } // namespace phosphor
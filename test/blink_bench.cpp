@@ -0,0 +1,86 @@
+#include "sysfs.hpp"
+#include "uring.hpp"
+
+#include <sys/param.h>
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+/* Compares the cost of programming a blink, i.e. the trigger, delay_on and
+ * delay_off stores, between the plain and the io_uring backed SysfsLed. The
+ * fake LED lives on tmpfs so the numbers reflect syscall overhead rather
+ * than a driver.
+ */
+
+static fs::path createFakeLed()
+{
+    const char* base = fs::is_directory("/dev/shm") ? "/dev/shm" : "/tmp";
+    std::array<char, MAXPATHLEN> buffer = {0};
+    snprintf(buffer.data(), buffer.size(), "%s/BlinkBench.XXXXXX", base);
+    char* dir = mkdtemp(buffer.data());
+    if (dir == nullptr)
+    {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    for (const auto* attr : {"brightness", "trigger", "delay_on", "delay_off"})
+    {
+        std::ofstream(fs::path(dir) / attr) << 0;
+    }
+    std::ofstream(fs::path(dir) / "max_brightness") << 255;
+
+    return dir;
+}
+
+template <typename Led>
+static double measure(const fs::path& dir, int iterations)
+{
+    Led led{fs::path(dir)};
+
+    // Warm up the descriptors and the ring
+    led.setBlink(500, 500);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        // Forget the shadow state so every setup reaches the files
+        led.invalidate();
+        led.setBlink(500, 500);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() /
+           iterations;
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = (argc > 1) ? std::atoi(argv[1]) : 10000;
+    auto dir = createFakeLed();
+
+    {
+        phosphor::led::UringSysfsLed probe{fs::path(dir)};
+        if (!probe.usesRing())
+        {
+            std::cout << "io_uring unavailable, both runs use syscalls"
+                      << std::endl;
+        }
+    }
+
+    auto plain = measure<phosphor::led::SysfsLed>(dir, iterations);
+    auto uring = measure<phosphor::led::UringSysfsLed>(dir, iterations);
+
+    std::cout << "blink setup, " << iterations << " iterations" << std::endl;
+    std::cout << "  syscalls: " << plain << " ns" << std::endl;
+    std::cout << "  io_uring: " << uring << " ns" << std::endl;
+
+    fs::remove_all(dir);
+    return 0;
+}
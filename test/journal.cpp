@@ -0,0 +1,78 @@
+#include "journal.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace fs = std::filesystem;
+
+using phosphor::led::Journal;
+using phosphor::led::Snapshot;
+
+class JournalTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        std::string tmplt = "/tmp/LedJournal.XXXXXX";
+        ASSERT_NE(mkdtemp(tmplt.data()), nullptr);
+        dir = tmplt;
+        file = dir / "journal" / "identify";
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(dir);
+    }
+
+    fs::path dir;
+    fs::path file;
+};
+
+TEST_F(JournalTest, emptyUntilRecorded)
+{
+    Journal journal(file, "boot");
+    EXPECT_FALSE(journal.load());
+    EXPECT_TRUE(fs::exists(file));
+}
+
+TEST_F(JournalTest, survivesRestart)
+{
+    {
+        Journal journal(file, "boot");
+        journal.record({255, "timer", 0, 250, 750});
+    }
+
+    Journal journal(file, "boot");
+    auto snapshot = journal.load();
+    ASSERT_TRUE(snapshot);
+    EXPECT_EQ(snapshot->maxBrightness, 255U);
+    EXPECT_EQ(snapshot->trigger, "timer");
+    EXPECT_EQ(snapshot->delayOn, 250U);
+    EXPECT_EQ(snapshot->delayOff, 750U);
+}
+
+TEST_F(JournalTest, ignoresOtherBoot)
+{
+    {
+        Journal journal(file, "boot");
+        journal.record({255, "none", 255, 0, 0});
+    }
+
+    Journal journal(file, "next boot");
+    EXPECT_FALSE(journal.load());
+}
+
+TEST_F(JournalTest, invalidateDropsRecord)
+{
+    Journal journal(file, "boot");
+    journal.record({255, "none", 255, 0, 0});
+    journal.invalidate();
+    EXPECT_FALSE(journal.load());
+
+    journal.record({255, "none", 0, 0, 0});
+    ASSERT_TRUE(journal.load());
+    EXPECT_EQ(journal.load()->brightness, 0U);
+}
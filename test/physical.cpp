@@ -1,8 +1,17 @@
 #include "physical.hpp"
 
+#include "journal.hpp"
+
 #include <sys/param.h>
 
 #include <sdbusplus/bus.hpp>
+#include <sdeventplus/event.hpp>
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -67,6 +76,10 @@ class MockLed : public phosphor::led::SysfsLed
     MOCK_METHOD1(setDelayOn, void(unsigned long ms));
     MOCK_METHOD0(getDelayOff, unsigned long());
     MOCK_METHOD1(setDelayOff, void(unsigned long ms));
+    MOCK_METHOD0(invalidate, void());
+    MOCK_METHOD1(hasTrigger, bool(const std::string& trigger));
+    MOCK_METHOD1(setPattern, void(const phosphor::led::Pattern& pattern));
+    MOCK_METHOD0(getPattern, phosphor::led::Pattern());
 };
 
 using ::testing::InSequence;
@@ -139,7 +152,67 @@ TEST(Physical, ctor_timer_trigger)
     EXPECT_CALL(led, getDelayOn()).WillOnce(Return(500));
     EXPECT_CALL(led, getDelayOff()).WillOnce(Return(500));
     phosphor::led::Physical phy(bus, ledObj, led);
-    EXPECT_EQ(phy.state(), Action::Off);
+    EXPECT_EQ(phy.state(), Action::Blink);
+    EXPECT_EQ(phy.dutyOn(), 50);
+    EXPECT_EQ(phy.period(), 1000);
+}
+
+TEST(Physical, restart_while_blinking_writes_nothing)
+{
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getTrigger()).WillByDefault(Return("timer"));
+    ON_CALL(led, getDelayOn()).WillByDefault(Return(250));
+    ON_CALL(led, getDelayOff()).WillByDefault(Return(750));
+    EXPECT_CALL(led, setTrigger(::testing::_)).Times(0);
+    EXPECT_CALL(led, setDelayOn(::testing::_)).Times(0);
+    EXPECT_CALL(led, setDelayOff(::testing::_)).Times(0);
+    phosphor::led::Physical phy(bus, ledObj, led);
+    EXPECT_EQ(phy.dutyOn(), 25);
+
+    // What the LED manager asserts again after the restart
+    phy.dutyOn(25);
+    phy.period(1000);
+    phy.state(Action::Blink);
+}
+
+TEST(Physical, ctor_pattern_trigger)
+{
+    using phosphor::led::Pattern;
+
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(200));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("pattern"));
+    ON_CALL(led, getPattern())
+        .WillByDefault(Return(Pattern{{200, 100}, {0, 900}}));
+    ON_CALL(led, hasTrigger("pattern")).WillByDefault(Return(true));
+    EXPECT_CALL(led, setPattern(::testing::_)).Times(0);
+    EXPECT_CALL(led, setTrigger(::testing::_)).Times(0);
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.setBlinkPattern({{100, 100}, {0, 900}});
+    EXPECT_EQ(phy.state(), Action::Blink);
+    phy.state(Action::Blink);
+}
+
+TEST(Physical, restart_with_other_pattern_rewrites_it)
+{
+    using phosphor::led::Pattern;
+
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(200));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("pattern"));
+    ON_CALL(led, getPattern())
+        .WillByDefault(Return(Pattern{{200, 500}, {0, 500}}));
+    ON_CALL(led, hasTrigger("pattern")).WillByDefault(Return(true));
+    EXPECT_CALL(led, setPattern(Pattern{{200, 100}, {0, 900}}));
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.setBlinkPattern({{100, 100}, {0, 900}});
+    EXPECT_EQ(phy.state(), Action::Blink);
+
+    // The sequence set up by an earlier --pattern is replaced
+    phy.state(Action::Blink);
 }
 
 TEST(Physical, off)
@@ -164,7 +237,7 @@ TEST(Physical, on)
     NiceMock<MockLed> led;
     ON_CALL(led, getMaxBrightness()).WillByDefault(Return(asserted));
     EXPECT_CALL(led, getTrigger()).WillOnce(Return("none"));
-    EXPECT_CALL(led, setTrigger("none"));
+    EXPECT_CALL(led, setTrigger(::testing::_)).Times(0);
     EXPECT_CALL(led, setBrightness(asserted));
     phosphor::led::Physical phy(bus, ledObj, led);
     phy.state(Action::On);
@@ -213,3 +286,457 @@ TEST(Physical, on_to_off)
     phy.state(Action::Off);
     EXPECT_EQ(phy.state(), Action::Off);
 }
+
+TEST(Physical, refresh_picks_up_external_change)
+{
+    constexpr unsigned long asserted = 127;
+
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(asserted));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    EXPECT_CALL(led, getBrightness())
+        .WillOnce(Return(phosphor::led::deasserted))
+        .WillOnce(Return(asserted));
+    EXPECT_CALL(led, invalidate());
+    phosphor::led::Physical phy(bus, ledObj, led);
+    EXPECT_EQ(phy.state(), Action::Off);
+    phy.refresh();
+    EXPECT_EQ(phy.state(), Action::On);
+}
+
+TEST(Physical, async_state_change)
+{
+    constexpr unsigned long asserted = 127;
+
+    auto event = sdeventplus::Event::get_new();
+    phosphor::led::Worker worker(event, 4);
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(asserted));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    EXPECT_CALL(led, setBrightness(asserted));
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.setWorker(worker);
+    phy.state(Action::On);
+    EXPECT_EQ(phy.state(), Action::On);
+    worker.flush();
+}
+
+TEST(Physical, async_failure_reverts_state)
+{
+    constexpr unsigned long asserted = 127;
+
+    auto event = sdeventplus::Event::get_new();
+    phosphor::led::Worker worker(event, 4);
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(asserted));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    ON_CALL(led, getBrightness())
+        .WillByDefault(Return(phosphor::led::deasserted));
+    EXPECT_CALL(led, setBrightness(asserted))
+        .WillOnce(::testing::Throw(
+            std::system_error(EIO, std::generic_category())));
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.setWorker(worker);
+    phy.state(Action::On);
+    EXPECT_EQ(phy.state(), Action::On);
+    while (phy.state() != Action::Off)
+    {
+        event.run(std::chrono::milliseconds(100));
+    }
+}
+
+TEST(Physical, coalesce_applies_last_state_only)
+{
+    constexpr unsigned long asserted = 127;
+
+    auto event = sdeventplus::Event::get_new();
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(asserted));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    EXPECT_CALL(led, setTrigger(::testing::_)).Times(0);
+    EXPECT_CALL(led, setBrightness(phosphor::led::deasserted)).Times(0);
+    EXPECT_CALL(led, setBrightness(asserted)).Times(1);
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.setCoalesceWindow(event, std::chrono::milliseconds(10));
+
+    phy.state(Action::On);
+    phy.state(Action::Off);
+    phy.state(Action::Blink);
+    phy.state(Action::On);
+    EXPECT_EQ(phy.state(), Action::On);
+
+    phy.flush();
+    EXPECT_EQ(phy.collapsedTransitions(), 3);
+}
+
+TEST(Physical, coalesce_back_to_written_state_writes_nothing)
+{
+    auto event = sdeventplus::Event::get_new();
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(127));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    EXPECT_CALL(led, setTrigger(::testing::_)).Times(0);
+    EXPECT_CALL(led, setBrightness(::testing::_)).Times(0);
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.setCoalesceWindow(event, std::chrono::milliseconds(1));
+
+    // Off replaced On, and is itself no change at all
+    phy.state(Action::On);
+    phy.state(Action::Off);
+    while (phy.collapsedTransitions() == 0)
+    {
+        event.run(std::chrono::milliseconds(100));
+    }
+    EXPECT_EQ(phy.collapsedTransitions(), 1);
+}
+
+TEST(Physical, blink_with_pattern)
+{
+    using phosphor::led::Pattern;
+
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(200));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    EXPECT_CALL(led, hasTrigger("pattern")).WillOnce(Return(true));
+    EXPECT_CALL(led, setTrigger("timer")).Times(0);
+    EXPECT_CALL(led, setPattern(Pattern{{200, 100}, {0, 100}, {100, 700}}));
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.setBlinkPattern({{100, 100}, {0, 100}, {50, 700}});
+    phy.state(Action::Blink);
+    EXPECT_EQ(phy.state(), Action::Blink);
+}
+
+TEST(Physical, blink_pattern_needs_trigger)
+{
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    EXPECT_CALL(led, hasTrigger("pattern")).WillOnce(Return(false));
+    EXPECT_CALL(led, setPattern(::testing::_)).Times(0);
+    EXPECT_CALL(led, setTrigger("timer"));
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.setBlinkPattern({{100, 100}, {0, 100}});
+    phy.state(Action::Blink);
+}
+
+TEST(Physical, soft_blink_without_timer_trigger)
+{
+    constexpr unsigned long asserted = 127;
+
+    auto event = sdeventplus::Event::get_new();
+    phosphor::led::SoftBlink engine(event);
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(asserted));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    EXPECT_CALL(led, hasTrigger("timer")).WillOnce(Return(false));
+    EXPECT_CALL(led, setTrigger("timer")).Times(0);
+    EXPECT_CALL(led, setTrigger("none")).Times(0);
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.setSoftBlink(engine, false);
+
+    phy.state(Action::Blink);
+    EXPECT_EQ(engine.size(), 1);
+
+    EXPECT_CALL(led, invalidate());
+    EXPECT_CALL(led, setBrightness(phosphor::led::deasserted));
+    phy.state(Action::Off);
+    EXPECT_EQ(engine.size(), 0);
+}
+
+TEST(Physical, async_soft_blink_starts_after_trigger_is_dropped)
+{
+    constexpr unsigned long asserted = 127;
+
+    auto event = sdeventplus::Event::get_new();
+    phosphor::led::Worker worker(event, 4);
+    phosphor::led::SoftBlink engine(event);
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(asserted));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("heartbeat"));
+    EXPECT_CALL(led, setTrigger("none"));
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.setSoftBlink(engine, true);
+    phy.setWorker(worker);
+
+    // The engine must not write brightness under the old trigger
+    phy.state(Action::Blink);
+    EXPECT_EQ(engine.size(), 0);
+    while (engine.size() == 0)
+    {
+        event.run(std::chrono::milliseconds(100));
+    }
+}
+
+TEST(Physical, soft_blink_takes_over_timer_blink)
+{
+    auto event = sdeventplus::Event::get_new();
+    phosphor::led::SoftBlink engine(event);
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(127));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("timer"));
+    ON_CALL(led, getDelayOn()).WillByDefault(Return(500));
+    ON_CALL(led, getDelayOff()).WillByDefault(Return(500));
+    EXPECT_CALL(led, setTrigger("none")).Times(1);
+    phosphor::led::Physical phy(bus, ledObj, led);
+    EXPECT_EQ(phy.state(), Action::Blink);
+
+    // The kernel timer must stop before the engine writes brightness
+    phy.setSoftBlink(engine, true);
+    EXPECT_EQ(engine.size(), 1);
+
+    phy.state(Action::Blink);
+    EXPECT_EQ(engine.size(), 1);
+}
+
+TEST(Physical, no_soft_blink_with_timer_trigger)
+{
+    auto event = sdeventplus::Event::get_new();
+    phosphor::led::SoftBlink engine(event);
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    EXPECT_CALL(led, hasTrigger("timer")).WillOnce(Return(true));
+    EXPECT_CALL(led, setTrigger("timer"));
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.setSoftBlink(engine, false);
+
+    phy.state(Action::Blink);
+    EXPECT_EQ(engine.size(), 0);
+}
+
+TEST(Physical, lazy_reads_sysfs_on_first_get)
+{
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    int probed = 0;
+    EXPECT_CALL(led, getMaxBrightness()).Times(0);
+    phosphor::led::Physical phy(bus, ledObj, led, phosphor::led::lazyProbe,
+                                [&probed]() { ++probed; });
+    EXPECT_FALSE(phy.isProbed());
+    ::testing::Mock::VerifyAndClearExpectations(&led);
+
+    EXPECT_CALL(led, getMaxBrightness()).WillOnce(Return(255));
+    EXPECT_CALL(led, getTrigger()).WillOnce(Return("none"));
+    EXPECT_CALL(led, getBrightness()).WillOnce(Return(255));
+    EXPECT_EQ(phy.state(), Action::On);
+    EXPECT_TRUE(phy.isProbed());
+    EXPECT_EQ(probed, 1);
+
+    // Later reads are served from the properties
+    EXPECT_EQ(phy.state(), Action::On);
+    EXPECT_EQ(probed, 1);
+}
+
+TEST(Physical, lazy_reads_sysfs_before_first_set)
+{
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    phosphor::led::Physical phy(bus, ledObj, led, phosphor::led::lazyProbe,
+                                nullptr);
+
+    // Already on, nothing to write
+    EXPECT_CALL(led, getMaxBrightness()).WillOnce(Return(255));
+    EXPECT_CALL(led, getTrigger()).WillOnce(Return("none"));
+    EXPECT_CALL(led, getBrightness()).WillOnce(Return(255));
+    EXPECT_CALL(led, setBrightness(::testing::_)).Times(0);
+    EXPECT_CALL(led, setTrigger(::testing::_)).Times(0);
+    phy.state(Action::On);
+    EXPECT_TRUE(phy.isProbed());
+}
+
+TEST(Physical, lazy_retries_failed_probe)
+{
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    phosphor::led::Physical phy(bus, ledObj, led, phosphor::led::lazyProbe,
+                                nullptr);
+
+    EXPECT_CALL(led, getMaxBrightness())
+        .WillOnce(::testing::Throw(
+            std::system_error(EIO, std::generic_category(), "max")))
+        .WillOnce(Return(255));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    EXPECT_ANY_THROW(phy.ensureProbed());
+    EXPECT_FALSE(phy.isProbed());
+
+    phy.ensureProbed();
+    EXPECT_TRUE(phy.isProbed());
+}
+
+TEST(Physical, update_reports_changed_properties)
+{
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(255));
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.dutyOn(50);
+    phy.period(1000);
+
+    EXPECT_CALL(led, setTrigger("timer"));
+    EXPECT_CALL(led, setDelayOn(250));
+    EXPECT_CALL(led, setDelayOff(750));
+    auto changed = phy.update(Action::Blink, 25, 1000);
+    EXPECT_EQ(changed, (std::vector<std::string>{"State", "DutyOn"}));
+    EXPECT_EQ(phy.state(), Action::Blink);
+    EXPECT_EQ(phy.dutyOn(), 25);
+
+    EXPECT_TRUE(phy.update(Action::Blink, 25, 1000).empty());
+}
+
+TEST(Physical, update_keeps_properties_on_failure)
+{
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(255));
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.dutyOn(50);
+    phy.period(1000);
+
+    EXPECT_CALL(led, setTrigger("timer"))
+        .WillOnce(::testing::Throw(
+            std::system_error(EIO, std::generic_category(), "trigger")));
+    EXPECT_ANY_THROW(phy.update(Action::Blink, 10, 500));
+    EXPECT_EQ(phy.state(), Action::Off);
+    EXPECT_EQ(phy.dutyOn(), 50);
+    EXPECT_EQ(phy.period(), 1000);
+}
+
+TEST(Physical, period_change_while_blinking_writes_delays_only)
+{
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    phosphor::led::Physical phy(bus, ledObj, led);
+    phy.dutyOn(50);
+    phy.period(1000);
+    phy.state(Action::Blink);
+
+    EXPECT_CALL(led, setTrigger(::testing::_)).Times(0);
+    EXPECT_CALL(led, setDelayOn(1000));
+    EXPECT_CALL(led, setDelayOff(1000));
+    phy.period(2000);
+    EXPECT_EQ(phy.period(), 2000);
+
+    // Nothing to write when the timing stays the same
+    EXPECT_CALL(led, setDelayOn(::testing::_)).Times(0);
+    EXPECT_CALL(led, setDelayOff(::testing::_)).Times(0);
+    phy.period(2000);
+}
+
+TEST(Physical, duty_change_while_steady_writes_nothing)
+{
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    phosphor::led::Physical phy(bus, ledObj, led);
+
+    EXPECT_CALL(led, setDelayOn(::testing::_)).Times(0);
+    EXPECT_CALL(led, setDelayOff(::testing::_)).Times(0);
+    phy.dutyOn(20);
+    EXPECT_EQ(phy.dutyOn(), 20);
+
+    EXPECT_CALL(led, setTrigger("timer"));
+    EXPECT_CALL(led, setDelayOn(200));
+    EXPECT_CALL(led, setDelayOff(800));
+    phy.period(1000);
+    phy.state(Action::Blink);
+}
+
+/** @brief Counts the writes made to a mock LED */
+static void countWrites(NiceMock<MockLed>& led, int& writes)
+{
+    auto count = [&writes](auto&&...) { ++writes; };
+    ON_CALL(led, setBrightness(::testing::_)).WillByDefault(count);
+    ON_CALL(led, setTrigger(::testing::_)).WillByDefault(count);
+    ON_CALL(led, setDelayOn(::testing::_)).WillByDefault(count);
+    ON_CALL(led, setDelayOff(::testing::_)).WillByDefault(count);
+    ON_CALL(led, setPattern(::testing::_)).WillByDefault(count);
+}
+
+TEST(Physical, transitions_write_the_minimum)
+{
+    struct Case
+    {
+        const char* trigger;
+        unsigned long brightness;
+        std::optional<Action> from;
+        Action to;
+        int writes;
+    };
+    const std::vector<Case> cases = {
+        {"none", 0, std::nullopt, Action::On, 1},
+        {"none", 0, std::nullopt, Action::Blink, 3},
+        {"none", 127, std::nullopt, Action::Off, 1},
+        {"none", 0, Action::On, Action::Off, 1},
+        {"none", 0, Action::On, Action::Blink, 3},
+        {"none", 0, Action::Blink, Action::Off, 1},
+        {"none", 0, Action::Blink, Action::On, 2},
+        {"heartbeat", 127, std::nullopt, Action::Off, 1},
+        {"heartbeat", 0, std::nullopt, Action::On, 2},
+        {"timer", 0, std::nullopt, Action::On, 2},
+    };
+
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    for (const auto& c : cases)
+    {
+        SCOPED_TRACE(std::string(c.trigger) + " " +
+                     std::to_string(c.brightness) + " to " +
+                     phosphor::led::Physical::convertActionToString(c.to));
+        NiceMock<MockLed> led;
+        ON_CALL(led, getMaxBrightness()).WillByDefault(Return(127));
+        ON_CALL(led, getTrigger()).WillByDefault(Return(c.trigger));
+        ON_CALL(led, getBrightness()).WillByDefault(Return(c.brightness));
+        ON_CALL(led, getDelayOn()).WillByDefault(Return(500));
+        ON_CALL(led, getDelayOff()).WillByDefault(Return(500));
+        phosphor::led::Physical phy(bus, ledObj, led);
+        if (c.from)
+        {
+            phy.state(*c.from);
+        }
+
+        int writes = 0;
+        countWrites(led, writes);
+        phy.state(c.to);
+        EXPECT_EQ(writes, c.writes);
+    }
+}
+
+TEST(Physical, journal_follows_state)
+{
+    sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+    NiceMock<MockLed> led;
+    ON_CALL(led, getMaxBrightness()).WillByDefault(Return(127));
+    ON_CALL(led, getTrigger()).WillByDefault(Return("none"));
+    phosphor::led::Physical phy(bus, ledObj, led);
+
+    auto dir = createSandbox();
+    chmod(dir.c_str(), S_IRWXU);
+    {
+        phosphor::led::Journal journal(dir / "led", "boot");
+        phy.setJournal(journal);
+        ASSERT_TRUE(journal.load());
+        EXPECT_EQ(journal.load()->brightness, phosphor::led::deasserted);
+
+        phy.state(Action::Blink);
+        auto snapshot = journal.load();
+        ASSERT_TRUE(snapshot);
+        EXPECT_EQ(snapshot->trigger, "timer");
+        EXPECT_EQ(snapshot->delayOn, 500U);
+        EXPECT_EQ(snapshot->delayOff, 500U);
+
+        phy.state(Action::On);
+        EXPECT_EQ(journal.load()->brightness, 127U);
+    }
+    fs::remove_all(dir);
+}
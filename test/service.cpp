@@ -0,0 +1,61 @@
+#include "service.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using phosphor::led::getDbusName;
+using phosphor::led::getLedDescr;
+using phosphor::led::LedDescr;
+using phosphor::led::parsePhaseGroup;
+
+static std::string dbusName(const std::string& sysfsName)
+{
+    LedDescr descr;
+    getLedDescr(sysfsName, descr);
+    return getDbusName(descr);
+}
+
+TEST(Service, nameFromDeviceOnly)
+{
+    EXPECT_EQ("identify", dbusName("identify"));
+}
+
+TEST(Service, nameFromDeviceAndColor)
+{
+    LedDescr descr;
+    getLedDescr("front:blue", descr);
+    EXPECT_EQ("blue", descr.color);
+    EXPECT_EQ("front_blue", getDbusName(descr));
+}
+
+TEST(Service, nameMovesColorLast)
+{
+    LedDescr descr;
+    getLedDescr("front:green:fault", descr);
+    EXPECT_EQ("front", descr.devicename);
+    EXPECT_EQ("green", descr.color);
+    EXPECT_EQ("fault", descr.function);
+    EXPECT_EQ("front_fault_green", getDbusName(descr));
+}
+
+TEST(Service, nameSkipsEmptyColor)
+{
+    EXPECT_EQ("front_fault", dbusName("front::fault"));
+}
+
+TEST(Service, phaseGroupNames)
+{
+    auto group = parsePhaseGroup("rear_fault,front_fault,rear_fault");
+    EXPECT_EQ(2U, group.size());
+    EXPECT_TRUE(group.contains("front_fault"));
+    EXPECT_TRUE(group.contains("rear_fault"));
+}
+
+TEST(Service, phaseGroupRejectsEmptyName)
+{
+    EXPECT_THROW(parsePhaseGroup("front_fault,,rear_fault"),
+                 std::invalid_argument);
+    EXPECT_THROW(parsePhaseGroup("front_fault,"), std::invalid_argument);
+}
@@ -0,0 +1,93 @@
+#include "softblink.hpp"
+
+#include <sys/param.h>
+
+#include <sdeventplus/event.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+using phosphor::led::SoftBlink;
+namespace fs = std::filesystem;
+
+static SoftBlink::Clock::time_point at(SoftBlink::Clock::duration d)
+{
+    return SoftBlink::Clock::time_point(d);
+}
+
+TEST(SoftBlink, phaseAlignedOnPeriod)
+{
+    auto p = SoftBlink::phase(at(10s + 100ms), 250ms, 750ms);
+    EXPECT_TRUE(p.lit);
+    EXPECT_EQ(at(10s + 250ms), p.next);
+
+    p = SoftBlink::phase(at(10s + 250ms), 250ms, 750ms);
+    EXPECT_FALSE(p.lit);
+    EXPECT_EQ(at(11s), p.next);
+
+    p = SoftBlink::phase(at(11s), 250ms, 750ms);
+    EXPECT_TRUE(p.lit);
+    EXPECT_EQ(at(11s + 250ms), p.next);
+}
+
+TEST(SoftBlink, samePeriodSamePhase)
+{
+    // LEDs started at different times still toggle together
+    auto a = SoftBlink::phase(at(3s + 10ms), 500ms, 500ms);
+    auto b = SoftBlink::phase(at(3s + 420ms), 500ms, 500ms);
+    EXPECT_EQ(a.lit, b.lit);
+    EXPECT_EQ(a.next, b.next);
+}
+
+TEST(SoftBlink, steadyWithoutOnOrOffTime)
+{
+    auto p = SoftBlink::phase(at(1s), 0ms, 500ms);
+    EXPECT_FALSE(p.lit);
+    EXPECT_EQ(SoftBlink::Clock::time_point::max(), p.next);
+
+    p = SoftBlink::phase(at(1s), 500ms, 0ms);
+    EXPECT_TRUE(p.lit);
+    EXPECT_EQ(SoftBlink::Clock::time_point::max(), p.next);
+}
+
+TEST(SoftBlink, togglesBrightness)
+{
+    std::array<char, MAXPATHLEN> buffer = {0};
+    strncpy(buffer.data(), "/tmp/SoftBlink.XXXXXX", buffer.size() - 1);
+    char* dir = mkdtemp(buffer.data());
+    if (dir == nullptr)
+    {
+        throw std::system_error(errno, std::system_category());
+    }
+    fs::path root(dir);
+    std::ofstream(root / "brightness") << 0;
+
+    auto event = sdeventplus::Event::get_new();
+    SoftBlink engine(event);
+    engine.start(root, 42, 5, 5);
+    EXPECT_EQ(1, engine.size());
+
+    bool seenOn = false;
+    bool seenOff = false;
+    for (int i = 0; i < 100 && !(seenOn && seenOff); ++i)
+    {
+        event.run(std::chrono::milliseconds(100));
+        unsigned long value = 0;
+        std::ifstream(root / "brightness") >> value;
+        seenOn |= value == 42;
+        seenOff |= value == 0;
+    }
+    EXPECT_TRUE(seenOn);
+    EXPECT_TRUE(seenOff);
+
+    engine.stop(root);
+    EXPECT_EQ(0, engine.size());
+    fs::remove_all(root);
+}
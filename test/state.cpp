@@ -0,0 +1,72 @@
+#include "state.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace fs = std::filesystem;
+
+using phosphor::led::loadState;
+using phosphor::led::saveState;
+using phosphor::led::SavedState;
+
+class State : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        std::string tmplt = "/tmp/LedState.XXXXXX";
+        ASSERT_NE(mkdtemp(tmplt.data()), nullptr);
+        dir = tmplt;
+        file = dir / "run" / "state";
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(dir);
+    }
+
+    fs::path dir;
+    fs::path file;
+};
+
+TEST_F(State, roundTrip)
+{
+    SavedState state;
+    state["front:blue:fault"] = {255, "none", 128, 0, 0};
+    state["identify"] = {1, "timer", 0, 250, 750};
+
+    saveState(file, state);
+    auto loaded = loadState(file);
+
+    ASSERT_EQ(loaded.size(), 2U);
+    const auto& fault = loaded.at("front:blue:fault");
+    EXPECT_EQ(fault.maxBrightness, 255U);
+    EXPECT_EQ(fault.trigger, "none");
+    EXPECT_EQ(fault.brightness, 128U);
+    const auto& identify = loaded.at("identify");
+    EXPECT_EQ(identify.trigger, "timer");
+    EXPECT_EQ(identify.delayOn, 250U);
+    EXPECT_EQ(identify.delayOff, 750U);
+    EXPECT_FALSE(fs::exists(file.string() + ".new"));
+}
+
+TEST_F(State, missingFileIsEmpty)
+{
+    EXPECT_TRUE(loadState(file).empty());
+}
+
+TEST_F(State, skipsMalformedLines)
+{
+    fs::create_directories(file.parent_path());
+    std::ofstream(file) << "good 255 none 0 0 0\n"
+                        << "short 255 none\n"
+                        << "bad x none 0 0 0\n";
+
+    auto loaded = loadState(file);
+    ASSERT_EQ(loaded.size(), 1U);
+    EXPECT_TRUE(loaded.contains("good"));
+}
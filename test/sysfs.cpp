@@ -21,11 +21,48 @@
 #include <cerrno>
 #include <cstdlib>
 #include <fstream>
+#include <new>
 
 #include <gtest/gtest.h>
 
 namespace fs = std::filesystem;
 
+static size_t allocations = 0;
+
+/* Out of line so the compiler does not pair the replaced operator new with
+ * free() and flag a mismatched deallocation. */
+[[gnu::noinline]] static void* countedAlloc(size_t size)
+{
+    ++allocations;
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    return std::malloc(size);
+}
+
+[[gnu::noinline]] static void countedFree(void* p)
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    std::free(p);
+}
+
+void* operator new(size_t size)
+{
+    if (void* p = countedAlloc(size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, size_t /*size*/) noexcept
+{
+    countedFree(p);
+}
+
 constexpr unsigned long maxBrightnessVal = 128;
 
 class FakeSysfsLed : public phosphor::led::SysfsLed
@@ -117,3 +154,198 @@ TEST(Sysfs, getDelayOff)
     fsl.setDelayOff(delayOff);
     ASSERT_EQ(delayOff, fsl.getDelayOff());
 }
+
+TEST(Sysfs, attributeDescriptorIsReused)
+{
+    constexpr unsigned long brightness = 42;
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+
+    fsl.setBrightness(brightness);
+    fs::remove(fsl.path() / "brightness");
+
+    // Still reachable through the descriptor opened by setBrightness()
+    ASSERT_EQ(brightness, fsl.getBrightness());
+}
+
+TEST(Sysfs, delaysReopenedAfterTriggerChange)
+{
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+
+    fsl.setDelayOn(100);
+    ASSERT_EQ(100, fsl.getDelayOn());
+
+    // Switching trigger makes the kernel recreate delay_on
+    fs::remove(fsl.path() / "delay_on");
+    std::ofstream(fsl.path() / "delay_on") << 500;
+    fsl.setTrigger("timer");
+
+    ASSERT_EQ(500, fsl.getDelayOn());
+}
+
+TEST(Sysfs, brightnessDoesNotAllocate)
+{
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+
+    // The first access opens the attribute, which may allocate
+    fsl.setBrightness(1);
+
+    size_t before = allocations;
+    for (unsigned long i = 0; i < 100; ++i)
+    {
+        fsl.setBrightness(i);
+        ASSERT_EQ(i, fsl.getBrightness());
+    }
+    ASSERT_EQ(before, allocations);
+}
+
+TEST(Sysfs, missingAttributeThrows)
+{
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+
+    fs::remove(fsl.path() / "delay_on");
+    ASSERT_THROW(fsl.getDelayOn(), std::system_error);
+    ASSERT_THROW(fsl.setDelayOn(100), std::system_error);
+}
+
+TEST(Sysfs, emptyAttributeThrows)
+{
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+
+    ASSERT_THROW(fsl.getBrightness(), std::system_error);
+}
+
+TEST(Sysfs, unchangedWritesAreElided)
+{
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+
+    fsl.setTrigger("none");
+    fsl.setBrightness(127);
+    ASSERT_EQ(0, fsl.elidedWrites());
+
+    // Change the files behind SysfsLed's back: elided writes leave them be
+    std::ofstream(fsl.path() / "trigger") << "timer";
+    std::ofstream(fsl.path() / "brightness") << 0;
+    fsl.setTrigger("none");
+    fsl.setBrightness(127);
+    ASSERT_EQ(2, fsl.elidedWrites());
+    ASSERT_EQ("timer", fsl.getTrigger());
+
+    fsl.invalidate();
+    fsl.setTrigger("none");
+    ASSERT_EQ(2, fsl.elidedWrites());
+    ASSERT_EQ("none", fsl.getTrigger());
+}
+
+TEST(Sysfs, triggerChangeForgetsDelays)
+{
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+
+    fsl.setTrigger("timer");
+    fsl.setDelayOn(100);
+    fsl.setDelayOn(100);
+    ASSERT_EQ(1, fsl.elidedWrites());
+
+    fsl.setTrigger("none");
+    fsl.setTrigger("timer");
+    fsl.setDelayOn(100);
+    ASSERT_EQ(1, fsl.elidedWrites());
+}
+
+TEST(Sysfs, zeroBrightnessRemovesTrigger)
+{
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+
+    fsl.setTrigger("timer");
+    fsl.setBrightness(0);
+    fsl.setTrigger("none");
+    ASSERT_EQ(1, fsl.elidedWrites());
+}
+
+TEST(Sysfs, parseTriggerList)
+{
+    auto list = phosphor::led::parseTriggerList("none [timer] heartbeat\n");
+    ASSERT_EQ("timer", list.active);
+    ASSERT_EQ((std::vector<std::string>{"none", "timer", "heartbeat"}),
+              list.available);
+
+    list = phosphor::led::parseTriggerList("[none] timer");
+    ASSERT_EQ("none", list.active);
+
+    list = phosphor::led::parseTriggerList("");
+    ASSERT_TRUE(list.active.empty());
+    ASSERT_TRUE(list.available.empty());
+}
+
+TEST(Sysfs, getTriggerReturnsActive)
+{
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+
+    std::ofstream(fsl.path() / "trigger") << "none [timer] heartbeat\n";
+    ASSERT_EQ("timer", fsl.getTrigger());
+}
+
+TEST(Sysfs, missingTriggerMeansNone)
+{
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+
+    // Kernels built without LED triggers have no trigger attribute
+    fs::remove(fsl.path() / "trigger");
+    ASSERT_EQ("none", fsl.getTrigger());
+    ASSERT_FALSE(fsl.hasTrigger("timer"));
+}
+
+TEST(Sysfs, availableTriggersAreCached)
+{
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+
+    std::ofstream(fsl.path() / "trigger") << "[none] timer pattern\n";
+    ASSERT_TRUE(fsl.hasTrigger("pattern"));
+
+    fs::remove(fsl.path() / "trigger");
+    ASSERT_TRUE(fsl.hasTrigger("timer"));
+    ASSERT_FALSE(fsl.hasTrigger("heartbeat"));
+}
+
+TEST(Sysfs, parsePattern)
+{
+    using phosphor::led::Pattern;
+
+    ASSERT_EQ((Pattern{{255, 100}, {0, 900}}),
+              phosphor::led::parsePattern("255 100 0 900\n"));
+    ASSERT_TRUE(phosphor::led::parsePattern("\n").empty());
+    ASSERT_THROW(phosphor::led::parsePattern("255 100 0"),
+                 std::invalid_argument);
+    ASSERT_THROW(phosphor::led::parsePattern("255 1x0"),
+                 std::invalid_argument);
+    ASSERT_EQ("255 100 0 900",
+              phosphor::led::formatPattern({{255, 100}, {0, 900}}));
+}
+
+TEST(Sysfs, setPatternPrefersHardware)
+{
+    const phosphor::led::Pattern pattern{{128, 50}, {0, 50}};
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+    std::ofstream(fsl.path() / "pattern");
+    std::ofstream(fsl.path() / "hw_pattern");
+
+    fsl.setPattern(pattern);
+    ASSERT_EQ("pattern", fsl.getTrigger());
+    ASSERT_EQ(pattern, fsl.getPattern());
+
+    std::ifstream hw(fsl.path() / "hw_pattern");
+    std::string content;
+    std::getline(hw, content);
+    ASSERT_EQ("128 50 0 50", content);
+}
+
+TEST(Sysfs, setPatternFallsBackToSoftware)
+{
+    const phosphor::led::Pattern pattern{{128, 50}, {0, 50}};
+    FakeSysfsLed fsl = FakeSysfsLed::create();
+    std::ofstream(fsl.path() / "pattern");
+
+    fsl.setPattern(pattern);
+    fsl.setPattern(pattern);
+    ASSERT_EQ(2, fsl.elidedWrites());
+    ASSERT_EQ(pattern, fsl.getPattern());
+}
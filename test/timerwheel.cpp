@@ -0,0 +1,167 @@
+#include "timerwheel.hpp"
+
+#include <sdeventplus/event.hpp>
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+using phosphor::led::TimerWheel;
+using Clock = TimerWheel::Clock;
+
+class TimerWheelTest : public ::testing::Test
+{
+  protected:
+    sdeventplus::Event event = sdeventplus::Event::get_new();
+    TimerWheel wheel{event};
+    Clock::time_point start = Clock::now();
+
+    /** @brief Wakes the wheel up whenever it asks until it goes idle */
+    size_t drain()
+    {
+        size_t wakeups = 0;
+        while (auto deadline = wheel.deadline())
+        {
+            wheel.advance(*deadline);
+            ++wakeups;
+        }
+        return wakeups;
+    }
+};
+
+TEST_F(TimerWheelTest, idleWheelIsDisarmed)
+{
+    EXPECT_EQ(0, wheel.size());
+    EXPECT_FALSE(wheel.deadline());
+}
+
+TEST_F(TimerWheelTest, dueTimersRunInOneWakeup)
+{
+    std::vector<int> ran;
+    TimerWheel::Timer a(wheel, [&](Clock::time_point) { ran.push_back(1); });
+    TimerWheel::Timer b(wheel, [&](Clock::time_point) { ran.push_back(2); });
+    TimerWheel::Timer c(wheel, [&](Clock::time_point) { ran.push_back(3); });
+    a.schedule(start + 10ms);
+    b.schedule(start + 12ms);
+    c.schedule(start + 30ms);
+    EXPECT_EQ(3, wheel.size());
+    ASSERT_TRUE(wheel.deadline());
+    EXPECT_LE(*wheel.deadline(), start + 11ms);
+
+    wheel.advance(start + 20ms);
+    EXPECT_EQ((std::vector<int>{1, 2}), ran);
+    EXPECT_FALSE(a.scheduled());
+    EXPECT_TRUE(c.scheduled());
+    EXPECT_EQ(1, wheel.size());
+    ASSERT_TRUE(wheel.deadline());
+    EXPECT_GE(*wheel.deadline(), start + 30ms);
+    EXPECT_LE(*wheel.deadline(), start + 31ms);
+
+    wheel.advance(start + 31ms);
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), ran);
+    EXPECT_FALSE(wheel.deadline());
+}
+
+TEST_F(TimerWheelTest, cancelledTimersDoNotRun)
+{
+    bool ran = false;
+    TimerWheel::Timer a(wheel, [&](Clock::time_point) { ran = true; });
+    a.schedule(start + 5ms);
+    {
+        TimerWheel::Timer b(wheel, [&](Clock::time_point) { ran = true; });
+        b.schedule(start + 6ms);
+        EXPECT_EQ(2, wheel.size());
+    }
+    EXPECT_EQ(1, wheel.size());
+
+    a.cancel();
+    EXPECT_EQ(0, wheel.size());
+    EXPECT_FALSE(wheel.deadline());
+
+    wheel.advance(start + 1s);
+    EXPECT_FALSE(ran);
+}
+
+TEST_F(TimerWheelTest, rescheduleFromCallback)
+{
+    // A periodic timer catches up on every period it missed
+    auto due = start + 100ms;
+    size_t runs = 0;
+    TimerWheel::Timer timer(wheel, [&](Clock::time_point now) {
+        EXPECT_GE(now, due);
+        ++runs;
+        due += 100ms;
+        timer.schedule(due);
+    });
+    timer.schedule(due);
+
+    wheel.advance(start + 1s + 50ms);
+    EXPECT_EQ(10, runs);
+    EXPECT_TRUE(timer.scheduled());
+    ASSERT_TRUE(wheel.deadline());
+    EXPECT_GE(*wheel.deadline(), start + 1s + 100ms);
+}
+
+TEST_F(TimerWheelTest, callbackCancelsAnotherDueTimer)
+{
+    // Due at the same tick, whichever runs first cancels the other
+    size_t runs = 0;
+    std::optional<TimerWheel::Timer> a;
+    std::optional<TimerWheel::Timer> b;
+    a.emplace(wheel, [&](Clock::time_point) {
+        ++runs;
+        b.reset();
+    });
+    b.emplace(wheel, [&](Clock::time_point) {
+        ++runs;
+        a->cancel();
+    });
+    a->schedule(start + 10ms);
+    b->schedule(start + 10ms);
+
+    wheel.advance(start + 20ms);
+    EXPECT_EQ(1, runs);
+    EXPECT_EQ(0, wheel.size());
+    EXPECT_FALSE(wheel.deadline());
+}
+
+TEST_F(TimerWheelTest, longDelaysCascadeDown)
+{
+    // Minutes, hours and beyond the reach of the wheel
+    std::vector<Clock::duration> delays = {5s, 2min, 3h, 10h};
+    std::vector<std::optional<Clock::time_point>> ranAt(delays.size());
+    std::vector<std::unique_ptr<TimerWheel::Timer>> timers;
+    for (size_t i = 0; i < delays.size(); ++i)
+    {
+        timers.emplace_back(std::make_unique<TimerWheel::Timer>(
+            wheel, [&ranAt, i](Clock::time_point now) {
+                EXPECT_FALSE(ranAt[i]);
+                ranAt[i] = now;
+            }));
+        timers.back()->schedule(start + delays[i]);
+    }
+
+    // Only the timers themselves and the odd move down wake it up
+    EXPECT_LE(drain(), 8);
+    for (size_t i = 0; i < delays.size(); ++i)
+    {
+        ASSERT_TRUE(ranAt[i]);
+        EXPECT_GE(*ranAt[i], start + delays[i]);
+        EXPECT_LE(*ranAt[i], start + delays[i] + 1ms);
+    }
+}
+
+TEST_F(TimerWheelTest, pastTimeRunsOnNextWakeup)
+{
+    bool ran = false;
+    TimerWheel::Timer timer(wheel, [&](Clock::time_point) { ran = true; });
+    timer.schedule(start - 1s);
+    ASSERT_TRUE(wheel.deadline());
+    EXPECT_LE(*wheel.deadline(), start + 1ms);
+
+    wheel.advance(start + 1ms);
+    EXPECT_TRUE(ran);
+}
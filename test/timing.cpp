@@ -0,0 +1,110 @@
+#include "timing.hpp"
+
+#include <cstdint>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+using phosphor::led::BlinkTiming;
+using phosphor::led::toDelays;
+using phosphor::led::toTiming;
+
+TEST(Timing, delaysAddUpToPeriod)
+{
+    for (uint32_t p = 0; p <= UINT16_MAX; ++p)
+    {
+        for (uint32_t d = 0; d <= UINT8_MAX; ++d)
+        {
+            auto [on, off] = toDelays(d, p);
+            ASSERT_EQ(on + off, p) << d << "% of " << p;
+        }
+    }
+}
+
+TEST(Timing, delaysGrowWithDuty)
+{
+    for (uint32_t p = 0; p <= UINT16_MAX; ++p)
+    {
+        // Off entirely and on entirely, whatever the period
+        EXPECT_EQ(toDelays(0, p), std::make_pair(0UL, 0UL + p)) << p;
+        EXPECT_EQ(toDelays(100, p), std::make_pair(0UL + p, 0UL)) << p;
+        EXPECT_EQ(toDelays(UINT8_MAX, p), toDelays(100, p)) << p;
+
+        for (uint32_t d = 1; d <= 100; ++d)
+        {
+            ASSERT_GE(toDelays(d, p).first, toDelays(d - 1, p).first)
+                << d << "% of " << p;
+        }
+    }
+}
+
+TEST(Timing, wholeMillisecondsAreExact)
+{
+    // 1% steps of a multiple of 100ms, and halves of even periods
+    for (uint32_t p = 0; p <= UINT16_MAX; p += 100)
+    {
+        for (uint32_t d = 0; d <= 100; ++d)
+        {
+            ASSERT_EQ(toDelays(d, p).first, p / 100 * d) << d << "% of " << p;
+        }
+    }
+    for (uint32_t p = 0; p <= UINT16_MAX; p += 2)
+    {
+        ASSERT_EQ(toDelays(50, p), std::make_pair(0UL + p / 2, 0UL + p / 2))
+            << p;
+    }
+}
+
+TEST(Timing, timingRoundTripsFrom100ms)
+{
+    for (uint32_t p = 100; p <= UINT16_MAX; ++p)
+    {
+        for (uint32_t d = 0; d <= 100; ++d)
+        {
+            auto [on, off] = toDelays(d, p);
+            ASSERT_EQ(toTiming(on, off), (BlinkTiming{static_cast<uint8_t>(d),
+                                                      static_cast<uint16_t>(p)}))
+                << d << "% of " << p;
+        }
+    }
+}
+
+TEST(Timing, delaysRoundTripUpTo100ms)
+{
+    for (unsigned long on = 0; on <= 100; ++on)
+    {
+        for (unsigned long off = 0; on + off <= 100; ++off)
+        {
+            if (on + off == 0)
+            {
+                continue;
+            }
+            auto [duty, period] = toTiming(on, off);
+            auto delays = toDelays(duty, period);
+            ASSERT_EQ(delays.first, on) << on << "/" << off;
+            ASSERT_EQ(delays.second, off) << on << "/" << off;
+        }
+    }
+}
+
+TEST(Timing, reapplyingWhatWasReadIsStable)
+{
+    for (uint32_t p = 0; p <= UINT16_MAX; ++p)
+    {
+        for (uint32_t d = 0; d <= 100; ++d)
+        {
+            auto delays = toDelays(d, p);
+            auto [duty, period] = toTiming(delays.first, delays.second);
+            ASSERT_EQ(toDelays(duty, period), delays) << d << "% of " << p;
+        }
+    }
+}
+
+TEST(Timing, longDelaysSaturatePeriod)
+{
+    EXPECT_EQ(toTiming(100000, 100000), (BlinkTiming{50, UINT16_MAX}));
+    EXPECT_EQ(toTiming(1, 0), (BlinkTiming{100, 1}));
+    EXPECT_EQ(toTiming(0, 40), (BlinkTiming{0, 40}));
+    EXPECT_EQ(toTiming(~0UL, ~0UL), (BlinkTiming{50, UINT16_MAX}));
+    EXPECT_EQ(toTiming(0, 0), (BlinkTiming{50, 0}));
+}
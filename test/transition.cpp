@@ -0,0 +1,155 @@
+#include "transition.hpp"
+
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using phosphor::led::Brightness;
+using phosphor::led::Goal;
+using phosphor::led::plan;
+using phosphor::led::Trigger;
+using phosphor::led::Write;
+
+static std::vector<Write> writes(Trigger trigger, Brightness brightness,
+                                 Goal goal)
+{
+    const auto& p = plan(trigger, brightness, goal);
+    return {p.begin(), p.end()};
+}
+
+TEST(Transition, steadyWithoutTriggerOnlyWritesBrightness)
+{
+    EXPECT_EQ(writes(Trigger::None, Brightness::Lit, Goal::Off),
+              std::vector<Write>{Write::Brightness});
+    EXPECT_EQ(writes(Trigger::None, Brightness::Zero, Goal::On),
+              std::vector<Write>{Write::Brightness});
+    EXPECT_TRUE(writes(Trigger::None, Brightness::Zero, Goal::Off).empty());
+    EXPECT_TRUE(writes(Trigger::None, Brightness::Lit, Goal::On).empty());
+}
+
+TEST(Transition, droppingTriggerTurnsOff)
+{
+    for (auto trigger : {Trigger::Timer, Trigger::Pattern, Trigger::Other})
+    {
+        EXPECT_EQ(writes(trigger, Brightness::Unknown, Goal::Off),
+                  std::vector<Write>{Write::TriggerNone});
+        EXPECT_EQ(writes(trigger, Brightness::Unknown, Goal::On),
+                  (std::vector<Write>{Write::TriggerNone, Write::Brightness}));
+    }
+}
+
+TEST(Transition, blinkKeepsTriggerInPlace)
+{
+    EXPECT_EQ(writes(Trigger::None, Brightness::Zero, Goal::Timer),
+              std::vector<Write>{Write::Blink});
+    EXPECT_EQ(writes(Trigger::Timer, Brightness::Unknown, Goal::Timer),
+              std::vector<Write>{Write::Delays});
+    EXPECT_TRUE(
+        writes(Trigger::Pattern, Brightness::Unknown, Goal::Pattern).empty());
+    EXPECT_TRUE(writes(Trigger::None, Brightness::Lit, Goal::Soft).empty());
+    EXPECT_EQ(writes(Trigger::Timer, Brightness::Unknown, Goal::Soft),
+              std::vector<Write>{Write::TriggerNone});
+}
+
+struct Cell
+{
+    Trigger trigger;
+    Brightness brightness;
+    Goal goal;
+    std::vector<Write> expected;
+};
+
+/** @brief Every transition with the writes it takes, spelled out */
+static const std::vector<Cell> cells = {
+    {Trigger::None, Brightness::Zero, Goal::Off, {}},
+    {Trigger::None, Brightness::Zero, Goal::On, {Write::Brightness}},
+    {Trigger::None, Brightness::Zero, Goal::Timer, {Write::Blink}},
+    {Trigger::None, Brightness::Zero, Goal::Pattern, {Write::Pattern}},
+    {Trigger::None, Brightness::Zero, Goal::Soft, {}},
+    {Trigger::None, Brightness::Lit, Goal::Off, {Write::Brightness}},
+    {Trigger::None, Brightness::Lit, Goal::On, {}},
+    {Trigger::None, Brightness::Lit, Goal::Timer, {Write::Blink}},
+    {Trigger::None, Brightness::Lit, Goal::Pattern, {Write::Pattern}},
+    {Trigger::None, Brightness::Lit, Goal::Soft, {}},
+    {Trigger::None, Brightness::Unknown, Goal::Off, {Write::Brightness}},
+    {Trigger::None, Brightness::Unknown, Goal::On, {Write::Brightness}},
+    {Trigger::None, Brightness::Unknown, Goal::Timer, {Write::Blink}},
+    {Trigger::None, Brightness::Unknown, Goal::Pattern, {Write::Pattern}},
+    {Trigger::None, Brightness::Unknown, Goal::Soft, {}},
+    {Trigger::Timer, Brightness::Zero, Goal::Off, {Write::TriggerNone}},
+    {Trigger::Timer, Brightness::Zero, Goal::On,
+     {Write::TriggerNone, Write::Brightness}},
+    {Trigger::Timer, Brightness::Zero, Goal::Timer, {Write::Delays}},
+    {Trigger::Timer, Brightness::Zero, Goal::Pattern, {Write::Pattern}},
+    {Trigger::Timer, Brightness::Zero, Goal::Soft, {Write::TriggerNone}},
+    {Trigger::Timer, Brightness::Lit, Goal::Off, {Write::TriggerNone}},
+    {Trigger::Timer, Brightness::Lit, Goal::On,
+     {Write::TriggerNone, Write::Brightness}},
+    {Trigger::Timer, Brightness::Lit, Goal::Timer, {Write::Delays}},
+    {Trigger::Timer, Brightness::Lit, Goal::Pattern, {Write::Pattern}},
+    {Trigger::Timer, Brightness::Lit, Goal::Soft, {Write::TriggerNone}},
+    {Trigger::Timer, Brightness::Unknown, Goal::Off, {Write::TriggerNone}},
+    {Trigger::Timer, Brightness::Unknown, Goal::On,
+     {Write::TriggerNone, Write::Brightness}},
+    {Trigger::Timer, Brightness::Unknown, Goal::Timer, {Write::Delays}},
+    {Trigger::Timer, Brightness::Unknown, Goal::Pattern, {Write::Pattern}},
+    {Trigger::Timer, Brightness::Unknown, Goal::Soft, {Write::TriggerNone}},
+    {Trigger::Pattern, Brightness::Zero, Goal::Off, {Write::TriggerNone}},
+    {Trigger::Pattern, Brightness::Zero, Goal::On,
+     {Write::TriggerNone, Write::Brightness}},
+    {Trigger::Pattern, Brightness::Zero, Goal::Timer, {Write::Blink}},
+    {Trigger::Pattern, Brightness::Zero, Goal::Pattern, {}},
+    {Trigger::Pattern, Brightness::Zero, Goal::Soft, {Write::TriggerNone}},
+    {Trigger::Pattern, Brightness::Lit, Goal::Off, {Write::TriggerNone}},
+    {Trigger::Pattern, Brightness::Lit, Goal::On,
+     {Write::TriggerNone, Write::Brightness}},
+    {Trigger::Pattern, Brightness::Lit, Goal::Timer, {Write::Blink}},
+    {Trigger::Pattern, Brightness::Lit, Goal::Pattern, {}},
+    {Trigger::Pattern, Brightness::Lit, Goal::Soft, {Write::TriggerNone}},
+    {Trigger::Pattern, Brightness::Unknown, Goal::Off, {Write::TriggerNone}},
+    {Trigger::Pattern, Brightness::Unknown, Goal::On,
+     {Write::TriggerNone, Write::Brightness}},
+    {Trigger::Pattern, Brightness::Unknown, Goal::Timer, {Write::Blink}},
+    {Trigger::Pattern, Brightness::Unknown, Goal::Pattern, {}},
+    {Trigger::Pattern, Brightness::Unknown, Goal::Soft, {Write::TriggerNone}},
+    {Trigger::Other, Brightness::Zero, Goal::Off, {Write::TriggerNone}},
+    {Trigger::Other, Brightness::Zero, Goal::On,
+     {Write::TriggerNone, Write::Brightness}},
+    {Trigger::Other, Brightness::Zero, Goal::Timer, {Write::Blink}},
+    {Trigger::Other, Brightness::Zero, Goal::Pattern, {Write::Pattern}},
+    {Trigger::Other, Brightness::Zero, Goal::Soft, {Write::TriggerNone}},
+    {Trigger::Other, Brightness::Lit, Goal::Off, {Write::TriggerNone}},
+    {Trigger::Other, Brightness::Lit, Goal::On,
+     {Write::TriggerNone, Write::Brightness}},
+    {Trigger::Other, Brightness::Lit, Goal::Timer, {Write::Blink}},
+    {Trigger::Other, Brightness::Lit, Goal::Pattern, {Write::Pattern}},
+    {Trigger::Other, Brightness::Lit, Goal::Soft, {Write::TriggerNone}},
+    {Trigger::Other, Brightness::Unknown, Goal::Off, {Write::TriggerNone}},
+    {Trigger::Other, Brightness::Unknown, Goal::On,
+     {Write::TriggerNone, Write::Brightness}},
+    {Trigger::Other, Brightness::Unknown, Goal::Timer, {Write::Blink}},
+    {Trigger::Other, Brightness::Unknown, Goal::Pattern, {Write::Pattern}},
+    {Trigger::Other, Brightness::Unknown, Goal::Soft, {Write::TriggerNone}},
+};
+
+TEST(Transition, everyCellWritesExactly)
+{
+    constexpr size_t all = phosphor::led::transition::triggers *
+                           phosphor::led::transition::brightnesses *
+                           phosphor::led::transition::goals;
+    ASSERT_EQ(all, cells.size());
+
+    std::set<std::tuple<Trigger, Brightness, Goal>> seen;
+    for (const auto& cell : cells)
+    {
+        EXPECT_TRUE(
+            seen.emplace(cell.trigger, cell.brightness, cell.goal).second);
+        EXPECT_EQ(writes(cell.trigger, cell.brightness, cell.goal),
+                  cell.expected)
+            << "trigger " << static_cast<int>(cell.trigger) << ", brightness "
+            << static_cast<int>(cell.brightness) << ", goal "
+            << static_cast<int>(cell.goal);
+    }
+}
@@ -0,0 +1,75 @@
+#include "uevent.hpp"
+
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+using phosphor::led::parseUevent;
+
+using namespace std::string_literals;
+
+TEST(Uevent, parsesKernelMessage)
+{
+    auto message = "add@/devices/platform/leds/leds/front:blue:fault\0"
+                   "ACTION=add\0"
+                   "DEVPATH=/devices/platform/leds/leds/front:blue:fault\0"
+                   "SUBSYSTEM=leds\0"
+                   "SEQNUM=1234\0"s;
+
+    auto uevent = parseUevent(message);
+    ASSERT_TRUE(uevent);
+    EXPECT_EQ("add", uevent->action);
+    EXPECT_EQ("/devices/platform/leds/leds/front:blue:fault", uevent->devpath);
+    EXPECT_EQ("leds", uevent->subsystem);
+    EXPECT_EQ("front:blue:fault", uevent->name());
+}
+
+TEST(Uevent, parsesWithoutTrailingNul)
+{
+    auto message = "remove@/devices/x/leds/identify\0"
+                   "ACTION=remove\0"
+                   "DEVPATH=/devices/x/leds/identify\0"
+                   "SUBSYSTEM=leds"s;
+
+    auto uevent = parseUevent(message);
+    ASSERT_TRUE(uevent);
+    EXPECT_EQ("remove", uevent->action);
+    EXPECT_EQ("leds", uevent->subsystem);
+    EXPECT_EQ("identify", uevent->name());
+}
+
+TEST(Uevent, rejectsUdevMessage)
+{
+    auto message = "libudev\0"
+                   "ACTION=add\0"
+                   "DEVPATH=/devices/x/leds/identify\0"
+                   "SUBSYSTEM=leds\0"s;
+
+    EXPECT_FALSE(parseUevent(message));
+}
+
+TEST(Uevent, rejectsMissingFields)
+{
+    auto message = "add@/devices/x/leds/identify\0"
+                   "ACTION=add\0"
+                   "SUBSYSTEM=leds\0"s;
+
+    EXPECT_FALSE(parseUevent(message));
+    EXPECT_FALSE(parseUevent(""));
+}
+
+TEST(Uevent, ignoresMalformedFields)
+{
+    auto message = "change@/devices/x/leds/identify\0"
+                   "garbage\0"
+                   "\0"
+                   "ACTION=change\0"
+                   "DEVPATH=/devices/x/leds/identify\0"
+                   "SUBSYSTEM=leds\0"
+                   "TRIGGER=timer\0"s;
+
+    auto uevent = parseUevent(message);
+    ASSERT_TRUE(uevent);
+    EXPECT_EQ("change", uevent->action);
+}
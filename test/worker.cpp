@@ -0,0 +1,107 @@
+#include "worker.hpp"
+
+#include <sdeventplus/event.hpp>
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using phosphor::led::Worker;
+
+/* Dispatches the event loop until the condition holds */
+template <typename Pred>
+static void runUntil(const sdeventplus::Event& event, Pred pred)
+{
+    while (!pred())
+    {
+        event.run(std::chrono::milliseconds(100));
+    }
+}
+
+TEST(Worker, completesOnEventLoop)
+{
+    auto event = sdeventplus::Event::get_new();
+    Worker worker(event, 4);
+
+    bool ran = false;
+    bool done = false;
+    ASSERT_TRUE(worker.submit([&ran]() { ran = true; },
+                              [&done](std::exception_ptr error) {
+                                  EXPECT_FALSE(error);
+                                  done = true;
+                              }));
+
+    worker.flush();
+    EXPECT_TRUE(ran);
+    EXPECT_FALSE(done);
+
+    runUntil(event, [&done]() { return done; });
+}
+
+TEST(Worker, reportsJobFailure)
+{
+    auto event = sdeventplus::Event::get_new();
+    Worker worker(event, 4);
+
+    bool failed = false;
+    ASSERT_TRUE(worker.submit([]() { throw std::runtime_error("io"); },
+                              [&failed](std::exception_ptr error) {
+                                  failed = static_cast<bool>(error);
+                              }));
+
+    runUntil(event, [&failed]() { return failed; });
+}
+
+TEST(Worker, rejectsWhenFull)
+{
+    auto event = sdeventplus::Event::get_new();
+    Worker worker(event, 1);
+
+    std::promise<void> started;
+    std::promise<void> release;
+    auto blocker = release.get_future().share();
+    ASSERT_TRUE(worker.submit(
+        [&started, blocker]() {
+            started.set_value();
+            blocker.wait();
+        },
+        nullptr));
+    started.get_future().wait();
+
+    // The first job is running, which leaves room for exactly one more
+    ASSERT_TRUE(worker.submit([]() {}, nullptr));
+    ASSERT_FALSE(worker.submit([]() {}, nullptr));
+
+    release.set_value();
+    worker.flush();
+    ASSERT_TRUE(worker.submit([]() {}, nullptr));
+}
+
+TEST(Worker, reportsStalledJob)
+{
+    auto event = sdeventplus::Event::get_new();
+    Worker worker(event, 1);
+    EXPECT_FALSE(worker.stalled(std::chrono::milliseconds(0)));
+
+    std::promise<void> started;
+    std::promise<void> release;
+    auto blocker = release.get_future().share();
+    ASSERT_TRUE(worker.submit(
+        [&started, blocker]() {
+            started.set_value();
+            blocker.wait();
+        },
+        nullptr));
+    started.get_future().wait();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_TRUE(worker.stalled(std::chrono::milliseconds(10)));
+    EXPECT_FALSE(worker.stalled(std::chrono::hours(1)));
+
+    release.set_value();
+    worker.flush();
+    EXPECT_FALSE(worker.stalled(std::chrono::milliseconds(0)));
+}
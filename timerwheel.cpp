@@ -0,0 +1,308 @@
+#include "timerwheel.hpp"
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+namespace phosphor
+{
+namespace led
+{
+/** @brief Level of the list a timer is on while it runs */
+static constexpr uint8_t firing = 0xff;
+
+void TimerWheel::Timer::schedule(Clock::time_point when)
+{
+    cancel();
+
+    // An idle wheel may lag behind, catch up so the timer lands low
+    if (wheel.count == 0 && !wheel.running)
+    {
+        wheel.next = std::max(wheel.next, toTick(Clock::now()));
+    }
+
+    auto since = std::chrono::ceil<std::chrono::milliseconds>(
+        when.time_since_epoch());
+    expiry = static_cast<uint64_t>(std::max<int64_t>(since.count(), 0));
+    wheel.link(*this);
+
+    if (!wheel.running && (!wheel.armed || placed < *wheel.armed))
+    {
+        wheel.arm(placed);
+    }
+}
+
+void TimerWheel::Timer::cancel()
+{
+    if (!linked)
+    {
+        return;
+    }
+    wheel.unlink(*this);
+
+    // Nothing left to wake up for
+    if (wheel.count == 0 && !wheel.running)
+    {
+        wheel.arm(std::nullopt);
+    }
+}
+
+TimerWheel::TimerWheel(const sdeventplus::Event& event) :
+    next(toTick(Clock::now())),
+    tfd(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK))
+{
+    if (tfd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                "timerfd_create");
+    }
+    source.emplace(event, tfd, EPOLLIN,
+                   [this](sdeventplus::source::IO&, int, uint32_t) {
+                       expired();
+                   });
+}
+
+TimerWheel::~TimerWheel()
+{
+    // Timers outliving the wheel must not reach back into it
+    for (auto& level : wheel)
+    {
+        for (auto* head : level)
+        {
+            for (auto* timer = head; timer != nullptr; timer = timer->next)
+            {
+                timer->linked = false;
+            }
+        }
+    }
+    source.reset();
+    close(tfd);
+}
+
+uint64_t TimerWheel::toTick(Clock::time_point when)
+{
+    auto since = std::chrono::floor<std::chrono::milliseconds>(
+        when.time_since_epoch());
+    return static_cast<uint64_t>(std::max<int64_t>(since.count(), 0));
+}
+
+void TimerWheel::link(Timer& timer)
+{
+    auto tick = std::max(timer.expiry, next);
+    auto delta = tick - next;
+
+    // Further than the wheel reaches, the timer is moved down as late as
+    // possible and placed again from there
+    constexpr uint64_t reach = uint64_t{1} << (bits * levels);
+    if (delta >= reach)
+    {
+        delta = reach - 1;
+        tick = next + delta;
+    }
+
+    uint8_t level = 0;
+    while (level + 1U < levels && delta >= (uint64_t{1} << (bits * (level + 1))))
+    {
+        ++level;
+    }
+
+    timer.placed = tick;
+    timer.level = level;
+    timer.slot = static_cast<uint8_t>((tick >> (bits * level)) & (slots - 1));
+
+    auto& head = wheel[level][timer.slot];
+    timer.prev = nullptr;
+    timer.next = head;
+    if (head != nullptr)
+    {
+        head->prev = &timer;
+    }
+    head = &timer;
+    occupied[level] |= uint64_t{1} << timer.slot;
+    timer.linked = true;
+    ++count;
+}
+
+void TimerWheel::unlink(Timer& timer)
+{
+    auto& head =
+        (timer.level == firing) ? due : wheel[timer.level][timer.slot];
+    if (timer.prev != nullptr)
+    {
+        timer.prev->next = timer.next;
+    }
+    else
+    {
+        head = timer.next;
+    }
+    if (timer.next != nullptr)
+    {
+        timer.next->prev = timer.prev;
+    }
+    if (timer.level != firing && head == nullptr)
+    {
+        occupied[timer.level] &= ~(uint64_t{1} << timer.slot);
+    }
+    timer.prev = timer.next = nullptr;
+    timer.linked = false;
+    --count;
+}
+
+std::optional<uint64_t> TimerWheel::nextEvent() const
+{
+    std::optional<uint64_t> event;
+    for (unsigned level = 0; level < levels; ++level)
+    {
+        if (occupied[level] == 0)
+        {
+            continue;
+        }
+
+        // Slots are handled when the tick reaches the start of their span,
+        // counted from the first such start not behind us
+        auto shift = bits * level;
+        auto base = (next + (uint64_t{1} << shift) - 1) >> shift;
+        auto rotated =
+            std::rotr(occupied[level], static_cast<int>(base & (slots - 1)));
+        auto tick = (base + std::countr_zero(rotated)) << shift;
+        if (!event || tick < *event)
+        {
+            event = tick;
+        }
+    }
+    return event;
+}
+
+std::optional<uint64_t> TimerWheel::nextWakeup() const
+{
+    std::optional<uint64_t> wakeup;
+    for (unsigned level = 0; level < levels; ++level)
+    {
+        if (occupied[level] == 0)
+        {
+            continue;
+        }
+
+        auto shift = bits * level;
+        auto base = (next + (uint64_t{1} << shift) - 1) >> shift;
+        auto rotated =
+            std::rotr(occupied[level], static_cast<int>(base & (slots - 1)));
+        auto slot = (base + std::countr_zero(rotated)) & (slots - 1);
+
+        // Moving a slot down needs no wakeup of its own, the earliest
+        // timer in it does
+        for (auto* timer = wheel[level][slot]; timer != nullptr;
+             timer = timer->next)
+        {
+            if (!wakeup || timer->placed < *wakeup)
+            {
+                wakeup = timer->placed;
+            }
+        }
+    }
+    return wakeup;
+}
+
+void TimerWheel::process(uint64_t tick, Clock::time_point now)
+{
+    next = tick;
+
+    // Higher levels first, their timers may land in a lower slot handled
+    // at this very tick
+    for (unsigned level = levels - 1; level > 0; --level)
+    {
+        auto shift = bits * level;
+        if ((tick & ((uint64_t{1} << shift) - 1)) != 0)
+        {
+            continue;
+        }
+        auto slot = (tick >> shift) & (slots - 1);
+        auto* timer = std::exchange(wheel[level][slot], nullptr);
+        occupied[level] &= ~(uint64_t{1} << slot);
+        while (timer != nullptr)
+        {
+            auto* following = timer->next;
+            --count;
+            link(*timer);
+            timer = following;
+        }
+    }
+
+    auto slot = tick & (slots - 1);
+    due = std::exchange(wheel[0][slot], nullptr);
+    occupied[0] &= ~(uint64_t{1} << slot);
+    for (auto* timer = due; timer != nullptr; timer = timer->next)
+    {
+        timer->level = firing;
+    }
+    next = tick + 1;
+
+    // Callbacks may schedule or cancel any timer, this one included
+    while (due != nullptr)
+    {
+        auto& timer = *due;
+        unlink(timer);
+        timer.callback(now);
+    }
+}
+
+void TimerWheel::advance(Clock::time_point now)
+{
+    auto tick = toTick(now);
+
+    running = true;
+    for (auto event = nextEvent(); event && *event <= tick;
+         event = nextEvent())
+    {
+        process(*event, now);
+    }
+    next = std::max(next, tick + 1);
+    running = false;
+
+    arm(nextWakeup());
+}
+
+void TimerWheel::arm(std::optional<uint64_t> tick)
+{
+    if (tick == armed)
+    {
+        return;
+    }
+
+    itimerspec spec{};
+    if (tick)
+    {
+        // Tick zero would disarm, it is long gone anyway
+        auto ms = std::max<uint64_t>(*tick, 1);
+        spec.it_value.tv_sec = static_cast<time_t>(ms / 1000);
+        spec.it_value.tv_nsec = static_cast<long>(ms % 1000) * 1000000;
+    }
+    // A zero it_value disarms the timer
+    timerfd_settime(tfd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    armed = tick;
+}
+
+auto TimerWheel::deadline() const -> std::optional<Clock::time_point>
+{
+    if (!armed)
+    {
+        return std::nullopt;
+    }
+    return Clock::time_point(std::chrono::milliseconds(*armed));
+}
+
+void TimerWheel::expired()
+{
+    uint64_t expirations = 0;
+    (void)read(tfd, &expirations, sizeof(expirations));
+
+    advance(Clock::now());
+}
+} // namespace led
+} // namespace phosphor
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/io.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+namespace phosphor
+{
+namespace led
+{
+/** @class TimerWheel
+ *  @brief Schedules software LED effects from a single timerfd.
+ *
+ *  Timers sit in a hierarchical wheel of millisecond ticks: four levels of
+ *  64 slots, each level counting in units of the whole level below, and
+ *  are moved down a level as their time comes closer. Everything due by
+ *  the time the timerfd fires runs in that one wakeup, the timerfd is only
+ *  armed for the earliest timer, and it is disarmed with no timer left.
+ *  Scheduling and cancelling take constant time whatever the number of
+ *  timers.
+ */
+class TimerWheel
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /** @class Timer
+     *  @brief A timer of the wheel, cancelled when destroyed
+     */
+    class Timer
+    {
+      public:
+        using Callback = std::function<void(Clock::time_point now)>;
+
+        Timer() = delete;
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+        Timer(Timer&&) = delete;
+        Timer& operator=(Timer&&) = delete;
+
+        /** @brief Creates a timer, not scheduled yet
+         *
+         *  @param[in] wheel    - wheel to run on
+         *  @param[in] callback - invoked with the current time when due
+         */
+        Timer(TimerWheel& wheel, Callback&& callback) :
+            wheel(wheel), callback(std::move(callback))
+        {}
+
+        ~Timer()
+        {
+            cancel();
+        }
+
+        /** @brief Schedules the timer, or reschedules it if it already is.
+         *         A time in the past runs it on the next wakeup.
+         *
+         *  @param[in] when - when to run, rounded up to the millisecond
+         */
+        void schedule(Clock::time_point when);
+
+        /** @brief Unschedules the timer, if it is */
+        void cancel();
+
+        /** @brief Whether the timer is scheduled */
+        bool scheduled() const
+        {
+            return linked;
+        }
+
+      private:
+        friend class TimerWheel;
+
+        TimerWheel& wheel;
+        Callback callback;
+        Timer* prev = nullptr;
+        Timer* next = nullptr;
+        /** @brief Tick the timer is due */
+        uint64_t expiry = 0;
+        /** @brief Tick the slot holding the timer stands for, before
+         *   expiry when it lies beyond the wheel
+         */
+        uint64_t placed = 0;
+        uint8_t level = 0;
+        uint8_t slot = 0;
+        bool linked = false;
+    };
+
+    TimerWheel() = delete;
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+    TimerWheel(TimerWheel&&) = delete;
+    TimerWheel& operator=(TimerWheel&&) = delete;
+
+    /** @brief Creates the timerfd on the event loop */
+    explicit TimerWheel(const sdeventplus::Event& event);
+
+    ~TimerWheel();
+
+    /** @brief Number of timers scheduled */
+    size_t size() const
+    {
+        return count;
+    }
+
+    /** @brief When the timerfd is due to fire, if armed */
+    std::optional<Clock::time_point> deadline() const;
+
+    /** @brief Runs every timer due by a point in time, then arms the
+     *         timerfd for the next one. Called from the event loop when
+     *         the timerfd fires.
+     *
+     *  @param[in] now - current time
+     */
+    void advance(Clock::time_point now);
+
+  private:
+    static constexpr unsigned bits = 6;
+    static constexpr unsigned slots = 1U << bits;
+    static constexpr unsigned levels = 4;
+
+    /** @brief Places a timer by its expiry, relative to the next tick */
+    void link(Timer& timer);
+    void unlink(Timer& timer);
+
+    /** @brief First tick from next on at which a slot has to be handled */
+    std::optional<uint64_t> nextEvent() const;
+
+    /** @brief Earliest tick a timer is placed at */
+    std::optional<uint64_t> nextWakeup() const;
+
+    /** @brief Moves the timers of a higher level slot down, runs those
+     *         due at a tick and moves on to the next tick
+     */
+    void process(uint64_t tick, Clock::time_point now);
+
+    /** @brief Arms the timerfd for a tick, or disarms it */
+    void arm(std::optional<uint64_t> tick);
+
+    /** @brief Handles the timerfd expiring */
+    void expired();
+
+    static uint64_t toTick(Clock::time_point when);
+
+    std::array<std::array<Timer*, slots>, levels> wheel{};
+    /** @brief Slots holding timers, one bit per slot */
+    std::array<uint64_t, levels> occupied{};
+    /** @brief Next tick to handle, every earlier one has been */
+    uint64_t next;
+    size_t count = 0;
+    /** @brief Tick the timerfd is armed for, if any */
+    std::optional<uint64_t> armed;
+    /** @brief Whether timers are running, the timerfd is armed after */
+    bool running = false;
+    /** @brief Timers due at the tick being handled, not run yet */
+    Timer* due = nullptr;
+
+    int tfd;
+    std::optional<sdeventplus::source::IO> source;
+};
+} // namespace led
+} // namespace phosphor
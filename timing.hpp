@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace phosphor
+{
+namespace led
+{
+/** @brief Blink timing as the Physical interface gives it */
+struct BlinkTiming
+{
+    /** @brief Percentage of the period the LED is on */
+    uint8_t dutyOn;
+    /** @brief Period in milliseconds */
+    uint16_t period;
+
+    constexpr bool operator==(const BlinkTiming&) const = default;
+};
+
+/** @brief Computes delay_on and delay_off for a blink. Both are rounded
+ *         to the nearest millisecond and always add up to the period.
+ *         DutyOn above 100 counts as 100.
+ *
+ *  @param[in] dutyOn - percentage of the period the LED is on
+ *  @param[in] period - period in milliseconds
+ *  @return On and off times in milliseconds
+ */
+constexpr std::pair<unsigned long, unsigned long> toDelays(uint8_t dutyOn,
+                                                           uint16_t period)
+{
+    uint32_t d = std::min<uint32_t>(dutyOn, 100);
+    uint32_t p = period;
+    uint32_t on = (p * d + 50) / 100;
+    return {on, p - on};
+}
+
+/** @brief Derives DutyOn and Period from delay_on and delay_off, rounding
+ *         DutyOn to the nearest percent. Periods beyond what Period holds
+ *         saturate, DutyOn still comes from the actual delays.
+ *
+ *  Converting back with toDelays() gives the same delays whenever they
+ *  add up to 100ms or less, and any DutyOn and Period of 100ms or more
+ *  survive toDelays() and back unchanged, so re-applying what was read
+ *  never changes the LED.
+ *
+ *  @param[in] delayOn  - on time in milliseconds
+ *  @param[in] delayOff - off time in milliseconds
+ *  @return DutyOn and Period
+ */
+constexpr BlinkTiming toTiming(unsigned long delayOn, unsigned long delayOff)
+{
+    // Longer than 49 days, no need to tell apart
+    uint64_t on = std::min<uint64_t>(delayOn, UINT32_MAX);
+    uint64_t total = on + std::min<uint64_t>(delayOff, UINT32_MAX);
+    if (total == 0)
+    {
+        return {50, 0};
+    }
+
+    auto duty = static_cast<uint8_t>((on * 100 + total / 2) / total);
+    auto period = static_cast<uint16_t>(std::min<uint64_t>(total, UINT16_MAX));
+    return {duty, period};
+}
+} // namespace led
+} // namespace phosphor
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace phosphor
+{
+namespace led
+{
+/** @brief Trigger of a LED, as far as its brightness is concerned */
+enum class Trigger : uint8_t
+{
+    None,
+    Timer,
+    Pattern,
+    /** @brief Any other trigger, e.g. heartbeat, owning the brightness */
+    Other,
+};
+
+/** @brief Brightness of a LED without a trigger */
+enum class Brightness : uint8_t
+{
+    Zero,
+    Lit,
+    /** @brief Set by someone else, e.g. the software blink engine */
+    Unknown,
+};
+
+/** @brief How a LED is to be driven */
+enum class Goal : uint8_t
+{
+    Off,
+    On,
+    /** @brief Blink with the timer trigger */
+    Timer,
+    /** @brief Blink with the pattern trigger */
+    Pattern,
+    /** @brief Blink from the software engine, which needs no trigger */
+    Soft,
+};
+
+/** @brief SysfsLed operation taking part in a transition */
+enum class Write : uint8_t
+{
+    /** @brief Trigger none, which also turns the LED off */
+    TriggerNone,
+    /** @brief Brightness for the goal */
+    Brightness,
+    /** @brief Trigger timer followed by both delays */
+    Blink,
+    /** @brief Both delays, the timer trigger being already set */
+    Delays,
+    /** @brief The pattern, which sets the pattern trigger first */
+    Pattern,
+};
+
+/** @brief Operations bringing a LED to a goal, in the order to issue them */
+struct Plan
+{
+    std::array<Write, 2> writes{};
+    size_t size = 0;
+
+    constexpr const Write* begin() const
+    {
+        return writes.data();
+    }
+
+    constexpr const Write* end() const
+    {
+        return writes.data() + size;
+    }
+};
+
+namespace transition
+{
+inline constexpr size_t triggers = 4;
+inline constexpr size_t brightnesses = 3;
+inline constexpr size_t goals = 5;
+
+/** @brief Works out the fewest operations for one transition. The kernel
+ *         turns a LED off whenever it drops a trigger, so leaving one for
+ *         Off takes no brightness write.
+ */
+constexpr Plan compute(Trigger trigger, Brightness brightness, Goal goal)
+{
+    switch (goal)
+    {
+        case Goal::Off:
+            if (trigger != Trigger::None)
+            {
+                return {{Write::TriggerNone}, 1};
+            }
+            if (brightness == Brightness::Zero)
+            {
+                return {};
+            }
+            return {{Write::Brightness}, 1};
+        case Goal::On:
+            if (trigger != Trigger::None)
+            {
+                return {{Write::TriggerNone, Write::Brightness}, 2};
+            }
+            if (brightness == Brightness::Lit)
+            {
+                return {};
+            }
+            return {{Write::Brightness}, 1};
+        case Goal::Timer:
+            if (trigger == Trigger::Timer)
+            {
+                return {{Write::Delays}, 1};
+            }
+            return {{Write::Blink}, 1};
+        case Goal::Pattern:
+            // The pattern is fixed at startup, once set it stays
+            if (trigger == Trigger::Pattern)
+            {
+                return {};
+            }
+            return {{Write::Pattern}, 1};
+        case Goal::Soft:
+            if (trigger == Trigger::None)
+            {
+                return {};
+            }
+            return {{Write::TriggerNone}, 1};
+    }
+    return {};
+}
+
+using Table = std::array<std::array<std::array<Plan, goals>, brightnesses>,
+                         triggers>;
+
+/** @brief Every transition, worked out at compile time */
+inline constexpr Table table = [] {
+    Table t{};
+    for (size_t i = 0; i < triggers; ++i)
+    {
+        for (size_t j = 0; j < brightnesses; ++j)
+        {
+            for (size_t k = 0; k < goals; ++k)
+            {
+                t[i][j][k] = compute(static_cast<Trigger>(i),
+                                     static_cast<Brightness>(j),
+                                     static_cast<Goal>(k));
+            }
+        }
+    }
+    return t;
+}();
+} // namespace transition
+
+/** @brief Looks up the operations taking a LED to a goal
+ *
+ *  @param[in] trigger    - trigger in effect
+ *  @param[in] brightness - brightness, only meaningful without a trigger
+ *  @param[in] goal       - how the LED is to be driven
+ */
+constexpr const Plan& plan(Trigger trigger, Brightness brightness, Goal goal)
+{
+    return transition::table[static_cast<size_t>(trigger)]
+                            [static_cast<size_t>(brightness)]
+                            [static_cast<size_t>(goal)];
+}
+
+static_assert(plan(Trigger::None, Brightness::Lit, Goal::Off).size == 1 &&
+                  *plan(Trigger::None, Brightness::Lit, Goal::Off).begin() ==
+                      Write::Brightness,
+              "On to Off without a trigger only writes brightness");
+static_assert(plan(Trigger::Timer, Brightness::Unknown, Goal::Off).size ==
+                      1 &&
+                  *plan(Trigger::Timer, Brightness::Unknown, Goal::Off)
+                          .begin() == Write::TriggerNone,
+              "Blink to Off only drops the trigger");
+} // namespace led
+} // namespace phosphor
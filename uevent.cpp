@@ -0,0 +1,169 @@
+#include "uevent.hpp"
+
+#include <linux/netlink.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <exception>
+#include <iostream>
+#include <system_error>
+
+namespace phosphor
+{
+namespace led
+{
+std::optional<Uevent> parseUevent(std::string_view message)
+{
+    // The header is followed by the same information as KEY=value pairs.
+    // Messages relayed by udev start with "libudev" and have no header.
+    auto end = message.find('\0');
+    auto header = message.substr(0, end);
+    if (header.find('@') == std::string_view::npos)
+    {
+        return std::nullopt;
+    }
+
+    Uevent uevent;
+    while (end != std::string_view::npos)
+    {
+        message.remove_prefix(end + 1);
+        end = message.find('\0');
+        auto field = message.substr(0, end);
+
+        auto equal = field.find('=');
+        if (equal == std::string_view::npos)
+        {
+            continue;
+        }
+        auto key = field.substr(0, equal);
+        auto value = field.substr(equal + 1);
+        if (key == "ACTION")
+        {
+            uevent.action = value;
+        }
+        else if (key == "DEVPATH")
+        {
+            uevent.devpath = value;
+        }
+        else if (key == "SUBSYSTEM")
+        {
+            uevent.subsystem = value;
+        }
+    }
+
+    if (uevent.action.empty() || uevent.devpath.empty() ||
+        uevent.subsystem.empty())
+    {
+        return std::nullopt;
+    }
+    return uevent;
+}
+
+UeventMonitor::UeventMonitor(const sdeventplus::Event& event,
+                             std::string subsystem, Callback&& callback,
+                             Overflow&& overflow) :
+    subsystem(std::move(subsystem)), callback(std::move(callback)),
+    overflow(std::move(overflow))
+{
+    fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                NETLINK_KOBJECT_UEVENT);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                "uevent socket");
+    }
+
+    // Room for the burst of uevents a driver probe produces. Failing only
+    // makes an overflow more likely, which is recovered from.
+    int size = 1024 * 1024;
+    (void)setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    // Group 1 carries the kernel's own uevents, udev uses the others
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+        auto error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(),
+                                "uevent bind");
+    }
+
+    source.emplace(event, fd, EPOLLIN,
+                   [this](sdeventplus::source::IO&, int, uint32_t) {
+                       receive();
+                   });
+}
+
+UeventMonitor::~UeventMonitor()
+{
+    source.reset();
+    close(fd);
+}
+
+void UeventMonitor::receive()
+{
+    // A uevent is at most a header and UEVENT_BUFFER_SIZE of environment
+    std::array<char, 8192> buf{};
+    while (true)
+    {
+        sockaddr_nl sender{};
+        iovec iov{buf.data(), buf.size()};
+        msghdr msg{};
+        msg.msg_name = &sender;
+        msg.msg_namelen = sizeof(sender);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        auto n = recvmsg(fd, &msg, 0);
+        if (n < 0)
+        {
+            if (errno == ENOBUFS)
+            {
+                std::cerr << "Lost uevents, socket buffer overflowed"
+                          << std::endl;
+                overflow();
+                continue;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN)
+            {
+                std::cerr << "Failed to receive uevent: "
+                          << std::generic_category().message(errno)
+                          << std::endl;
+            }
+            return;
+        }
+
+        // Only trust the kernel, any process may send to the group
+        if (sender.nl_pid != 0 || (msg.msg_flags & MSG_TRUNC) != 0)
+        {
+            continue;
+        }
+
+        auto uevent = parseUevent(std::string_view(buf.data(), n));
+        if (!uevent || uevent->subsystem != subsystem)
+        {
+            continue;
+        }
+
+        try
+        {
+            callback(*uevent);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to handle uevent for " << uevent->devpath
+                      << ": " << e.what() << std::endl;
+        }
+    }
+}
+} // namespace led
+} // namespace phosphor
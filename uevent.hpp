@@ -0,0 +1,82 @@
+#pragma once
+
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/io.hpp>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace phosphor
+{
+namespace led
+{
+/** @brief Fields of a kernel uevent that matter for LEDs */
+struct Uevent
+{
+    /** @brief "add", "remove", "change", ... */
+    std::string action;
+    /** @brief Device path below /sys, e.g. /devices/.../leds/<name> */
+    std::string devpath;
+    std::string subsystem;
+
+    /** @brief Last component of devpath, the name in the class directory */
+    std::string_view name() const
+    {
+        auto slash = devpath.rfind('/');
+        return std::string_view(devpath).substr(
+            slash == std::string::npos ? 0 : slash + 1);
+    }
+};
+
+/** @brief Parses a uevent as broadcast by the kernel:
+ *         "<action>@<devpath>" followed by NUL separated KEY=value pairs.
+ *
+ *  @param[in] message - datagram received from the netlink socket
+ *  @return The uevent, or nothing if the message is not a kernel uevent
+ *          or lacks ACTION, DEVPATH or SUBSYSTEM
+ */
+std::optional<Uevent> parseUevent(std::string_view message);
+
+/** @class UeventMonitor
+ *  @brief Receives the kernel uevents of one subsystem from a
+ *         NETLINK_KOBJECT_UEVENT socket in the event loop.
+ */
+class UeventMonitor
+{
+  public:
+    using Callback = std::function<void(const Uevent&)>;
+    using Overflow = std::function<void()>;
+
+    UeventMonitor() = delete;
+    UeventMonitor(const UeventMonitor&) = delete;
+    UeventMonitor& operator=(const UeventMonitor&) = delete;
+    UeventMonitor(UeventMonitor&&) = delete;
+    UeventMonitor& operator=(UeventMonitor&&) = delete;
+
+    /** @brief Opens the socket and starts listening
+     *
+     *  @param[in] event     - event loop to listen from
+     *  @param[in] subsystem - only uevents of this subsystem are reported
+     *  @param[in] callback  - invoked for every matching uevent
+     *  @param[in] overflow  - invoked when uevents were lost because the
+     *                         socket buffer filled up
+     */
+    UeventMonitor(const sdeventplus::Event& event, std::string subsystem,
+                  Callback&& callback, Overflow&& overflow);
+
+    ~UeventMonitor();
+
+  private:
+    /** @brief Receives every queued datagram */
+    void receive();
+
+    std::string subsystem;
+    Callback callback;
+    Overflow overflow;
+    int fd = -1;
+    std::optional<sdeventplus::source::IO> source;
+};
+} // namespace led
+} // namespace phosphor
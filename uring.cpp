@@ -0,0 +1,268 @@
+#include "uring.hpp"
+
+#include <fcntl.h>
+
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <functional>
+#include <string_view>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace phosphor
+{
+namespace led
+{
+/** @brief Fixed file slots used for the delay attributes */
+enum Slot : unsigned
+{
+    slotDelayOn = 0,
+    slotDelayOff,
+    slotCount,
+};
+
+Uring::~Uring()
+{
+    if (ready.value_or(false))
+    {
+        io_uring_queue_exit(&ring);
+    }
+}
+
+io_uring* Uring::get()
+{
+    if (!ready)
+    {
+        ready = false;
+        if (io_uring_queue_init(ringEntries, &ring, 0) < 0)
+        {
+            return nullptr;
+        }
+
+        // Opening into a fixed slot needs a sparse file table, which also
+        // rules out kernels too old for the direct open/close operations.
+        if (io_uring_register_files_sparse(&ring, slotCount) < 0)
+        {
+            io_uring_queue_exit(&ring);
+            return nullptr;
+        }
+        ready = true;
+    }
+    return *ready ? &ring : nullptr;
+}
+
+void Uring::reset()
+{
+    if (ready.value_or(false))
+    {
+        io_uring_queue_exit(&ring);
+    }
+    ring = {};
+    ready.reset();
+}
+
+UringSysfsLed::UringSysfsLed(fs::path&& root) :
+    SysfsLed(std::move(root)), own(std::make_unique<Uring>()), ring(*own),
+    pathDelayOn(this->root / attrDelayOn),
+    pathDelayOff(this->root / attrDelayOff)
+{}
+
+UringSysfsLed::UringSysfsLed(fs::path&& root, Uring& ring) :
+    SysfsLed(std::move(root)), ring(ring),
+    pathDelayOn(this->root / attrDelayOn),
+    pathDelayOff(this->root / attrDelayOff)
+{}
+
+bool UringSysfsLed::usesRing()
+{
+    std::lock_guard guard(ring.mutex());
+    return ring.get() != nullptr;
+}
+
+/** @brief Waits for and consumes a number of completions
+ *
+ *  @param[in] ring    - ring to reap
+ *  @param[in] count   - completions to consume
+ *  @param[in] handler - given the user data and result of each
+ *  @return 0, or a negative errno if the ring itself failed
+ */
+static int reap(io_uring* ring, size_t count,
+                const std::function<void(uint64_t, int)>& handler = nullptr)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        io_uring_cqe* cqe = nullptr;
+        int rc = 0;
+        do
+        {
+            rc = io_uring_wait_cqe(ring, &cqe);
+        } while (rc == -EINTR);
+        if (rc < 0)
+        {
+            return rc;
+        }
+
+        auto data = io_uring_cqe_get_data64(cqe);
+        int res = cqe->res;
+        io_uring_cqe_seen(ring, cqe);
+        if (handler)
+        {
+            handler(data, res);
+        }
+    }
+    return 0;
+}
+
+/** @brief Formats a delay followed by a newline into buf */
+static std::string_view formatDelay(std::array<char, 32>& buf,
+                                    unsigned long ms)
+{
+    auto [end, ec] = std::to_chars(buf.data(), buf.data() + buf.size() - 1,
+                                   ms);
+    if (ec != std::errc())
+    {
+        throw std::system_error(std::make_error_code(ec));
+    }
+    *end++ = '\n';
+    return {buf.data(), static_cast<size_t>(end - buf.data())};
+}
+
+void UringSysfsLed::setBlink(unsigned long delayOn, unsigned long delayOff)
+{
+    // With the timer already running the delays are in place and no
+    // ordering is at stake, and the shadow may spare the writes altogether.
+    if (shadowTrigger == "timer")
+    {
+        return SysfsLed::setBlink(delayOn, delayOff);
+    }
+
+    std::unique_lock guard(ring.mutex());
+    io_uring* uring = ring.get();
+    if (uring == nullptr)
+    {
+        guard.unlock();
+        return SysfsLed::setBlink(delayOn, delayOff);
+    }
+
+    int triggerFd = fileTrigger.get(root);
+    if (triggerFd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), attrTrigger);
+    }
+
+    static constexpr std::string_view timer = "timer\n";
+    std::array<char, 32> onBuf{};
+    std::array<char, 32> offBuf{};
+    auto on = formatDelay(onBuf, delayOn);
+    auto off = formatDelay(offBuf, delayOff);
+
+    struct Step
+    {
+        const char* attr;
+        size_t expect;
+    };
+    static constexpr size_t chainLength = 7;
+    std::array<Step, chainLength> steps{{
+        {attrTrigger, timer.size()},
+        {attrDelayOn, 0},
+        {attrDelayOn, on.size()},
+        {attrDelayOn, 0},
+        {attrDelayOff, 0},
+        {attrDelayOff, off.size()},
+        {attrDelayOff, 0},
+    }};
+
+    std::array<io_uring_sqe*, chainLength> sqe{};
+    for (size_t i = 0; i < sqe.size(); ++i)
+    {
+        sqe[i] = io_uring_get_sqe(uring);
+        if (sqe[i] == nullptr)
+        {
+            // Cannot happen with a drained ring of ringEntries entries. The
+            // entries already taken must not go out as a half chain later.
+            for (size_t j = 0; j < i; ++j)
+            {
+                io_uring_prep_nop(sqe[j]);
+                io_uring_sqe_set_flags(sqe[j], 0);
+            }
+            if (io_uring_submit_and_wait(uring, i) < 0 || reap(uring, i) < 0)
+            {
+                ring.reset();
+            }
+            guard.unlock();
+            return SysfsLed::setBlink(delayOn, delayOff);
+        }
+    }
+
+    io_uring_prep_write(sqe[0], triggerFd, timer.data(), timer.size(), 0);
+    io_uring_prep_openat_direct(sqe[1], AT_FDCWD, pathDelayOn.c_str(),
+                                O_WRONLY | O_CLOEXEC, 0, slotDelayOn);
+    io_uring_prep_write(sqe[2], slotDelayOn, on.data(), on.size(), 0);
+    io_uring_prep_close_direct(sqe[3], slotDelayOn);
+    io_uring_prep_openat_direct(sqe[4], AT_FDCWD, pathDelayOff.c_str(),
+                                O_WRONLY | O_CLOEXEC, 0, slotDelayOff);
+    io_uring_prep_write(sqe[5], slotDelayOff, off.data(), off.size(), 0);
+    io_uring_prep_close_direct(sqe[6], slotDelayOff);
+
+    for (size_t i = 0; i < sqe.size(); ++i)
+    {
+        unsigned flags = (i + 1 < sqe.size()) ? IOSQE_IO_LINK : 0;
+        if (i == 2 || i == 5)
+        {
+            flags |= IOSQE_FIXED_FILE;
+        }
+        io_uring_sqe_set_flags(sqe[i], flags);
+        io_uring_sqe_set_data64(sqe[i], i);
+    }
+
+    triggerChanged();
+    shadowTrigger.reset();
+
+    int rc = io_uring_submit_and_wait(uring, sqe.size());
+    if (rc < 0)
+    {
+        // Whatever was queued must not run as part of the next setup
+        ring.reset();
+        throw std::system_error(-rc, std::generic_category(), "io_uring");
+    }
+
+    // Reap every completion before reporting, so the ring is left empty.
+    // The first failure in the chain cancels the rest of it.
+    int err = 0;
+    const char* failed = nullptr;
+    rc = reap(uring, sqe.size(), [&](uint64_t data, int res) {
+        const auto& step = steps.at(data);
+        if (err != 0 || res == -ECANCELED)
+        {
+            return;
+        }
+        if (res < 0)
+        {
+            err = -res;
+            failed = step.attr;
+        }
+        else if (step.expect != 0 && static_cast<size_t>(res) != step.expect)
+        {
+            err = EIO;
+            failed = step.attr;
+        }
+    });
+    if (rc < 0)
+    {
+        // Completions may be left behind, start over with a new ring
+        ring.reset();
+        throw std::system_error(-rc, std::generic_category(), "io_uring");
+    }
+    if (err != 0)
+    {
+        throw std::system_error(err, std::generic_category(), failed);
+    }
+
+    shadowTrigger = "timer";
+    shadowDelayOn = delayOn;
+    shadowDelayOff = delayOff;
+}
+} // namespace led
+} // namespace phosphor
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "sysfs.hpp"
+
+#include <liburing.h>
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace phosphor
+{
+namespace led
+{
+/** @class Uring
+ *  @brief io_uring instance shared by the LEDs of a process
+ *
+ *  Blink setups are rare, so the ring and its file table are only set up
+ *  on the first one. Setups are serialized on the ring, as they share its
+ *  fixed file slots.
+ */
+class Uring
+{
+  public:
+    Uring() = default;
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+    Uring(Uring&&) = delete;
+    Uring& operator=(Uring&&) = delete;
+
+    ~Uring();
+
+    /** @brief Returns the ring, setting it up if needed, or nullptr when
+     *         the kernel cannot provide it. Callers hold mutex().
+     */
+    io_uring* get();
+
+    /** @brief Tears the ring down, to be set up afresh on next use. For
+     *         when entries or completions may have been left behind.
+     *         Callers hold mutex().
+     */
+    void reset();
+
+    /** @brief Guards the ring during a blink setup */
+    std::mutex& mutex()
+    {
+        return lock;
+    }
+
+  private:
+    /** @brief Submission queue depth, enough for one blink setup chain */
+    static constexpr unsigned ringEntries = 8;
+
+    std::mutex lock;
+    io_uring ring{};
+    /** @brief Whether the ring was set up, unset until first used */
+    std::optional<bool> ready;
+};
+
+/** @class UringSysfsLed
+ *  @brief SysfsLed that programs blinking through io_uring
+ *
+ *  The trigger, delay_on and delay_off stores are queued as a single linked
+ *  chain, opening the delay attributes in between as they only exist once
+ *  the timer trigger is selected. The kernel runs the chain in order and the
+ *  whole setup costs one io_uring_enter(2). When the ring cannot be set up
+ *  the plain SysfsLed path is used instead.
+ */
+class UringSysfsLed : public SysfsLed
+{
+  public:
+    /** @brief Creates a LED using a ring of its own */
+    explicit UringSysfsLed(std::filesystem::path&& root);
+
+    /** @brief Creates a LED using a ring shared with other LEDs, which
+     *         must outlive it
+     */
+    UringSysfsLed(std::filesystem::path&& root, Uring& ring);
+
+    UringSysfsLed() = delete;
+    UringSysfsLed(const UringSysfsLed& other) = delete;
+    UringSysfsLed(UringSysfsLed&& other) = delete;
+    UringSysfsLed& operator=(const UringSysfsLed& other) = delete;
+    UringSysfsLed& operator=(UringSysfsLed&& other) = delete;
+
+    ~UringSysfsLed() override = default;
+
+    void setBlink(unsigned long delayOn, unsigned long delayOff) override;
+
+    /** @brief Whether blink setup goes through io_uring */
+    bool usesRing();
+
+  private:
+    std::unique_ptr<Uring> own;
+    Uring& ring;
+
+    /** @brief Absolute paths of the delay attributes, kept alive for the
+     *         openat requests
+     */
+    std::string pathDelayOn;
+    std::string pathDelayOff;
+};
+} // namespace led
+} // namespace phosphor
@@ -0,0 +1,124 @@
+#include "worker.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <system_error>
+
+namespace phosphor
+{
+namespace led
+{
+Worker::Worker(const sdeventplus::Event& event, size_t capacity) :
+    capacity(capacity), efd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+    if (efd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "eventfd");
+    }
+    source.emplace(event, efd, EPOLLIN,
+                   [this](sdeventplus::source::IO&, int, uint32_t) {
+                       complete();
+                   });
+    thread = std::thread([this]() { run(); });
+}
+
+Worker::~Worker()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        queue.clear();
+    }
+    wake.notify_one();
+    thread.join();
+    source.reset();
+    close(efd);
+}
+
+bool Worker::submit(Job&& job, Done&& done)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (queue.size() >= capacity)
+        {
+            return false;
+        }
+        queue.push_back({std::move(job), std::move(done)});
+    }
+    wake.notify_one();
+    return true;
+}
+
+void Worker::flush()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    idle.wait(guard, [this]() { return queue.empty() && !busy; });
+}
+
+bool Worker::stalled(std::chrono::steady_clock::duration limit)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return busy && std::chrono::steady_clock::now() - started > limit;
+}
+
+void Worker::run()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    while (true)
+    {
+        wake.wait(guard, [this]() { return stopping || !queue.empty(); });
+        if (stopping)
+        {
+            return;
+        }
+
+        auto entry = std::move(queue.front());
+        queue.pop_front();
+        busy = true;
+        started = std::chrono::steady_clock::now();
+        guard.unlock();
+
+        std::exception_ptr error;
+        try
+        {
+            entry.job();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        guard.lock();
+        busy = false;
+        finished.push_back({std::move(entry.done), error});
+        uint64_t one = 1;
+        (void)write(efd, &one, sizeof(one));
+        if (queue.empty())
+        {
+            idle.notify_all();
+        }
+    }
+}
+
+void Worker::complete()
+{
+    uint64_t count = 0;
+    (void)read(efd, &count, sizeof(count));
+
+    std::deque<Result> results;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        results.swap(finished);
+    }
+    for (auto& result : results)
+    {
+        if (result.done)
+        {
+            result.done(result.error);
+        }
+    }
+}
+} // namespace led
+} // namespace phosphor
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/io.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace phosphor
+{
+namespace led
+{
+/** @class Worker
+ *  @brief Runs jobs on a dedicated thread through a bounded queue and
+ *         reports their completion back into the event loop.
+ *
+ *  Jobs run one at a time in submission order.
+ */
+class Worker
+{
+  public:
+    /** @brief Work to do on the worker thread */
+    using Job = std::function<void()>;
+
+    /** @brief Completion, run on the event loop with the exception thrown
+     *         by the job, if any
+     */
+    using Done = std::function<void(std::exception_ptr)>;
+
+    Worker() = delete;
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+    Worker(Worker&&) = delete;
+    Worker& operator=(Worker&&) = delete;
+
+    /** @brief Starts the worker thread
+     *
+     *  @param[in] event    - event loop receiving the completions
+     *  @param[in] capacity - maximum number of queued jobs
+     */
+    Worker(const sdeventplus::Event& event, size_t capacity);
+
+    /** @brief Finishes the running job, drops the queued ones and joins */
+    ~Worker();
+
+    /** @brief Queues a job
+     *
+     *  @param[in] job  - work to run on the worker thread
+     *  @param[in] done - completion to run on the event loop
+     *  @return false if the queue is full and the job was not queued
+     */
+    bool submit(Job&& job, Done&& done);
+
+    /** @brief Waits until every queued job has run. Their completions are
+     *         still delivered through the event loop.
+     */
+    void flush();
+
+    /** @brief Tells whether the running job has been running for too long,
+     *         as when a sysfs write hangs on a stuck bus
+     *
+     *  @param[in] limit - longest a job may take
+     */
+    bool stalled(std::chrono::steady_clock::duration limit);
+
+  private:
+    struct Entry
+    {
+        Job job;
+        Done done;
+    };
+
+    struct Result
+    {
+        Done done;
+        std::exception_ptr error;
+    };
+
+    /** @brief Worker thread body */
+    void run();
+
+    /** @brief Delivers finished jobs on the event loop */
+    void complete();
+
+    const size_t capacity;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<Entry> queue;
+    std::deque<Result> finished;
+    bool busy = false;
+    /** @brief When the running job started */
+    std::chrono::steady_clock::time_point started;
+    bool stopping = false;
+
+    /** @brief Signals finished jobs to the event loop */
+    int efd;
+    std::optional<sdeventplus::source::IO> source;
+
+    std::thread thread;
+};
+} // namespace led
+} // namespace phosphor